@@ -0,0 +1,411 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "buffer_mgr.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+#include "tables.h"
+
+/*
+ * Microbenchmark driver. Every benchmark uses fixed seeds, so two runs of the
+ * same build replay identical page and key sequences.
+ *
+ * Usage: bench [--quick] [--counters] [--json <file>]
+ *   --quick     run a tenth of the operations, for smoke testing
+ *   --counters  also count cycles, instructions, LLC, branch and dTLB misses
+ *               of every timed phase; an operation is one pinned page in the
+ *               buffer pool benchmarks and one record in the record ones
+ *   --json      where to write machine-readable results (default bench.json)
+ */
+
+#define BENCH_PAGE_FILE "bench_pages.bin"
+#define BENCH_TABLE "bench_table.bin"
+#define BENCH_SEED 42
+
+// Page file size and pool sizes of the buffer pool benchmarks
+#define BENCH_FILE_PAGES 512
+#define BENCH_SMALL_POOL 16
+#define BENCH_STRATEGY_POOL 64
+#define BENCH_ZIPF_THETA 0.99
+
+static long scale = 10;
+
+// Hit ratio of a pool since its last stats reset
+static double
+hitRatio (BM_BufferPool *bm)
+{
+	BM_Stats stats;
+	if (getBufferPoolStats(bm, &stats) != RC_OK || stats.hits + stats.misses == 0)
+		return -1;
+	return (double) stats.hits / (stats.hits + stats.misses);
+}
+
+// Pages pinned in a pool since its last stats reset
+static long
+pagesPinned (BM_BufferPool *bm)
+{
+	BM_Stats stats;
+	if (getBufferPoolStats(bm, &stats) != RC_OK)
+		return -1;
+	return stats.hits + stats.misses;
+}
+
+// Creates the page file used by the buffer pool benchmarks
+static RC
+createBenchPageFile (void)
+{
+	SM_FileHandle fHandle;
+	RC rc;
+
+	if ((rc = createPageFile(BENCH_PAGE_FILE)) != RC_OK)
+		return rc;
+	if ((rc = openPageFile(BENCH_PAGE_FILE, &fHandle)) != RC_OK)
+		return rc;
+	rc = ensureCapacity(BENCH_FILE_PAGES, &fHandle);
+	closePageFile(&fHandle);
+	return rc;
+}
+
+// Pins and unpins a resident page
+static void
+benchPinHit (BenchReport *report)
+{
+	BM_BufferPool bm;
+	BM_PageHandle page;
+	long ops = 100000 * scale;
+
+	memset(&page, 0, sizeof(page));
+	initBufferPool(&bm, BENCH_PAGE_FILE, BENCH_SMALL_POOL, RS_LRU, NULL);
+	pinPage(&bm, &page, 0);
+	unpinPage(&bm, &page);
+	resetBufferPoolStats(&bm);
+
+	double start = benchSeconds();
+	benchPhaseStart(report);
+	for (long i = 0; i < ops; i++)
+	{
+		pinPage(&bm, &page, 0);
+		unpinPage(&bm, &page);
+	}
+	benchPhaseStop(report);
+	double seconds = benchSeconds() - start;
+
+	benchReportAddPages(report, "pin_unpin_hit", ops, seconds, hitRatio(&bm), pagesPinned(&bm));
+	shutdownBufferPool(&bm);
+}
+
+// Pins pages in a cycle larger than the pool, so every pin is a miss
+static void
+benchPinMiss (BenchReport *report)
+{
+	BM_BufferPool bm;
+	BM_PageHandle page;
+	long ops = 2000 * scale;
+
+	memset(&page, 0, sizeof(page));
+	initBufferPool(&bm, BENCH_PAGE_FILE, BENCH_SMALL_POOL, RS_LRU, NULL);
+
+	double start = benchSeconds();
+	benchPhaseStart(report);
+	for (long i = 0; i < ops; i++)
+	{
+		pinPage(&bm, &page, (int) (i % BENCH_FILE_PAGES));
+		unpinPage(&bm, &page);
+	}
+	benchPhaseStop(report);
+	double seconds = benchSeconds() - start;
+
+	benchReportAddPages(report, "pin_unpin_miss", ops, seconds, hitRatio(&bm), pagesPinned(&bm));
+	shutdownBufferPool(&bm);
+}
+
+// Replays a uniform or zipfian page trace against one replacement strategy
+static void
+benchStrategy (BenchReport *report, ReplacementStrategy strategy, const char *strategyName, bool zipfian)
+{
+	BM_BufferPool bm;
+	BM_PageHandle page;
+	BenchRng rng;
+	ZipfGenerator zipf;
+	int k = 2;
+	long warmup = 500 * scale;
+	long ops = 5000 * scale;
+	char name[BENCH_NAME_LENGTH];
+
+	memset(&page, 0, sizeof(page));
+	benchRngSeed(&rng, BENCH_SEED);
+	zipfInit(&zipf, BENCH_FILE_PAGES, BENCH_ZIPF_THETA);
+	initBufferPool(&bm, BENCH_PAGE_FILE, BENCH_STRATEGY_POOL, strategy,
+			strategy == RS_LRU_K ? &k : NULL);
+
+	for (long i = 0; i < warmup + ops; i++)
+	{
+		if (i == warmup)
+			resetBufferPoolStats(&bm);
+		int pageNum = zipfian ? zipfNext(&zipf, &rng) : benchRngRange(&rng, BENCH_FILE_PAGES);
+		pinPage(&bm, &page, pageNum);
+		unpinPage(&bm, &page);
+	}
+
+	// Time a second identical pass with a warm pool
+	benchRngSeed(&rng, BENCH_SEED + 1);
+	resetBufferPoolStats(&bm);
+	double start = benchSeconds();
+	benchPhaseStart(report);
+	for (long i = 0; i < ops; i++)
+	{
+		int pageNum = zipfian ? zipfNext(&zipf, &rng) : benchRngRange(&rng, BENCH_FILE_PAGES);
+		pinPage(&bm, &page, pageNum);
+		unpinPage(&bm, &page);
+	}
+	benchPhaseStop(report);
+	double seconds = benchSeconds() - start;
+
+	snprintf(name, sizeof(name), "strategy_%s_%s", strategyName, zipfian ? "zipf" : "uniform");
+	benchReportAddPages(report, name, ops, seconds, hitRatio(&bm), pagesPinned(&bm));
+	shutdownBufferPool(&bm);
+}
+
+// Schema of the record benchmarks: (int a, char[4] b, int c)
+static Schema *
+benchSchema (void)
+{
+	char **names = (char **) malloc(sizeof(char *) * 3);
+	DataType *dataTypes = (DataType *) malloc(sizeof(DataType) * 3);
+	int *typeLength = (int *) malloc(sizeof(int) * 3);
+	int *keys = (int *) malloc(sizeof(int));
+
+	names[0] = strdup("a");
+	names[1] = strdup("b");
+	names[2] = strdup("c");
+	dataTypes[0] = DT_INT;
+	dataTypes[1] = DT_STRING;
+	dataTypes[2] = DT_INT;
+	typeLength[0] = 0;
+	typeLength[1] = 4;
+	typeLength[2] = 0;
+	keys[0] = 0;
+
+	return createSchema(3, names, dataTypes, typeLength, 1, keys);
+}
+
+// Fills a record with the deterministic contents of row i
+static void
+fillRecord (Record *record, Schema *schema, int i)
+{
+	Value value;
+
+	value.dt = DT_INT;
+	value.v.intV = i;
+	setAttr(record, schema, 0, &value);
+	value.dt = DT_STRING;
+	value.v.stringV = "abcd";
+	setAttr(record, schema, 1, &value);
+	value.dt = DT_INT;
+	value.v.intV = i % 100;
+	setAttr(record, schema, 2, &value);
+}
+
+// Scans the whole table, optionally with "a < limit", and returns the row count
+static long
+scanTable (RM_TableData *table, Schema *schema, int limit)
+{
+	RM_ScanHandle scan;
+	Record *record;
+	Expr *cond = NULL;
+	long rows = 0;
+
+	if (limit >= 0)
+	{
+		Expr *attr, *cons;
+		Value *bound = (Value *) malloc(sizeof(Value));
+		bound->dt = DT_INT;
+		bound->v.intV = limit;
+		MAKE_ATTRREF(attr, 0);
+		MAKE_CONS(cons, bound);
+		MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_SMALLER);
+	}
+
+	createRecord(&record, schema);
+	startScan(table, &scan, cond);
+	while (next(&scan, record) == RC_OK)
+		rows++;
+	closeScan(&scan);
+	freeRecord(record);
+	if (cond != NULL)
+		freeExpr(cond);
+	return rows;
+}
+
+// Record manager throughput: insert, random point lookups and full scans
+static void
+benchRecords (BenchReport *report, int numRecords)
+{
+	RM_TableData table;
+	Schema *schema = benchSchema();
+	Record *record;
+	RID *rids = (RID *) malloc(sizeof(RID) * numRecords);
+	BenchRng rng;
+	long lookups = 5000 * scale;
+	int scans = (int) scale;
+
+	initRecordManager(NULL);
+	createTable(BENCH_TABLE, schema);
+	openTable(&table, BENCH_TABLE);
+	createRecord(&record, schema);
+	BM_BufferPool *bm = &((RM_managementData *) table.managementData)->bm;
+
+	resetBufferPoolStats(bm);
+	double start = benchSeconds();
+	benchPhaseStart(report);
+	for (int i = 0; i < numRecords; i++)
+	{
+		fillRecord(record, schema, i);
+		if (insertRecord(&table, record) != RC_OK)
+		{
+			fprintf(stderr, "bench: insertRecord failed at row %d\n", i);
+			numRecords = i;
+			break;
+		}
+		rids[i] = record->id;
+	}
+	benchPhaseStop(report);
+	benchReportAddPages(report, "insertRecord", numRecords, benchSeconds() - start, hitRatio(bm), pagesPinned(bm));
+
+	benchRngSeed(&rng, BENCH_SEED);
+	resetBufferPoolStats(bm);
+	start = benchSeconds();
+	benchPhaseStart(report);
+	for (long i = 0; i < lookups && numRecords > 0; i++)
+		getRecord(&table, rids[benchRngRange(&rng, numRecords)], record);
+	benchPhaseStop(report);
+	benchReportAddPages(report, "getRecord", lookups, benchSeconds() - start, hitRatio(bm), pagesPinned(bm));
+
+	long rows = 0;
+	resetBufferPoolStats(bm);
+	start = benchSeconds();
+	benchPhaseStart(report);
+	for (int i = 0; i < scans; i++)
+		rows += scanTable(&table, schema, -1);
+	benchPhaseStop(report);
+	benchReportAddPages(report, "scan_full", rows, benchSeconds() - start, -1, pagesPinned(bm));
+
+	rows = 0;
+	resetBufferPoolStats(bm);
+	start = benchSeconds();
+	benchPhaseStart(report);
+	for (int i = 0; i < scans; i++)
+		rows += scanTable(&table, schema, numRecords / 2);
+	benchPhaseStop(report);
+	benchReportAddPages(report, "scan_predicate_half", rows, benchSeconds() - start, -1, pagesPinned(bm));
+
+	freeRecord(record);
+	closeTable(&table);
+	deleteTable(BENCH_TABLE);
+	shutdownRecordManager();
+	freeSchema(schema);
+	free(rids);
+}
+
+// Bulk load through insertRecords, one call per batch of rows
+static void
+benchBulkInsert (BenchReport *report, int numRecords, int batchSize)
+{
+	RM_TableData table;
+	Schema *schema = benchSchema();
+	Record **batch = (Record **) malloc(sizeof(Record *) * batchSize);
+	char name[BENCH_NAME_LENGTH];
+
+	initRecordManager(NULL);
+	createTable(BENCH_TABLE, schema);
+	openTable(&table, BENCH_TABLE);
+	for (int i = 0; i < batchSize; i++)
+		createRecord(&batch[i], schema);
+	BM_BufferPool *bm = &((RM_managementData *) table.managementData)->bm;
+
+	resetBufferPoolStats(bm);
+	double start = benchSeconds();
+	benchPhaseStart(report);
+	for (int done = 0; done < numRecords; done += batchSize)
+	{
+		int n = numRecords - done < batchSize ? numRecords - done : batchSize;
+		for (int i = 0; i < n; i++)
+			fillRecord(batch[i], schema, done + i);
+		if (insertRecords(&table, batch, n) != RC_OK)
+		{
+			fprintf(stderr, "bench: insertRecords failed after row %d\n", done);
+			numRecords = done;
+			break;
+		}
+	}
+	benchPhaseStop(report);
+	snprintf(name, sizeof(name), "insertRecords_batch%d", batchSize);
+	benchReportAddPages(report, name, numRecords, benchSeconds() - start, hitRatio(bm), pagesPinned(bm));
+
+	for (int i = 0; i < batchSize; i++)
+		freeRecord(batch[i]);
+	closeTable(&table);
+	deleteTable(BENCH_TABLE);
+	shutdownRecordManager();
+	freeSchema(schema);
+	free(batch);
+}
+
+int
+main (int argc, char **argv)
+{
+	const char *jsonFile = "bench.json";
+	bool counters = false;
+	BenchReport report;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+			scale = 1;
+		else if (strcmp(argv[i], "--counters") == 0)
+			counters = true;
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonFile = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--quick] [--counters] [--json <file>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	benchReportInit(&report, "microbenchmarks");
+	if (counters && benchCountersEnable(&report) == 0)
+		fprintf(stderr, "bench: hardware counters unavailable (no PMU or perf_event_paranoid too strict), timing only\n");
+
+	// Leftovers of an interrupted run would make the file creation fail
+	remove(BENCH_PAGE_FILE);
+	remove(BENCH_TABLE);
+
+	initStorageManager();
+	if (createBenchPageFile() != RC_OK)
+	{
+		fprintf(stderr, "bench: cannot create %s\n", BENCH_PAGE_FILE);
+		return 1;
+	}
+
+	benchPinHit(&report);
+	benchPinMiss(&report);
+	benchStrategy(&report, RS_FIFO, "FIFO", false);
+	benchStrategy(&report, RS_FIFO, "FIFO", true);
+	benchStrategy(&report, RS_LRU, "LRU", false);
+	benchStrategy(&report, RS_LRU, "LRU", true);
+	benchStrategy(&report, RS_LRU_K, "LRU-K", false);
+	benchStrategy(&report, RS_LRU_K, "LRU-K", true);
+	destroyPageFile(BENCH_PAGE_FILE);
+
+	benchRecords(&report, (int) (500 * scale));
+	benchBulkInsert(&report, (int) (500 * scale), 256);
+
+	RC rc = benchReportWriteJson(&report, jsonFile);
+	if (rc != RC_OK)
+		fprintf(stderr, "bench: cannot write %s\n", jsonFile);
+	benchReportFree(&report);
+	return rc == RC_OK ? 0 : 1;
+}
@@ -0,0 +1,415 @@
+#include "bench_util.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dt.h"
+#include "storage_mgr.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char *benchCounterNames[BENCH_NUM_COUNTERS] = {
+	[BENCH_CYCLES] = "cycles",
+	[BENCH_INSTRUCTIONS] = "instructions",
+	[BENCH_LLC_MISSES] = "llc_misses",
+	[BENCH_BRANCH_MISSES] = "branch_misses",
+	[BENCH_DTLB_MISSES] = "dtlb_misses",
+};
+
+/*
+ * Seeds a generator. Equal seeds give equal sequences.
+ */
+void
+benchRngSeed (BenchRng *rng, uint64_t seed)
+{
+	rng->state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+}
+
+// Returns the next 64 random bits (xorshift64*)
+uint64_t
+benchRngNext (BenchRng *rng)
+{
+	uint64_t x = rng->state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	rng->state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Returns a uniform double in [0, 1)
+double
+benchRngDouble (BenchRng *rng)
+{
+	return (benchRngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Returns a uniform integer in [0, n)
+int
+benchRngRange (BenchRng *rng, int n)
+{
+	return (int) (benchRngDouble(rng) * n);
+}
+
+/*
+ * Prepares a zipfian generator over [0, n) with skew theta in (0, 1).
+ * Computing the normalisation constant costs O(n) once.
+ *
+ * Returns:
+ * - RC_OK on success, RC_INVALID_INPUT for an empty range or a skew outside (0, 1).
+ */
+RC
+zipfInit (ZipfGenerator *zipf, int n, double theta)
+{
+	if (n <= 0 || theta <= 0.0 || theta >= 1.0)
+		return RC_INVALID_INPUT;
+
+	double zeta2 = 1.0 + pow(0.5, theta);
+	double zetan = 0.0;
+	for (int i = 1; i <= n; i++)
+		zetan += 1.0 / pow((double) i, theta);
+
+	zipf->n = n;
+	zipf->theta = theta;
+	zipf->alpha = 1.0 / (1.0 - theta);
+	zipf->zetan = zetan;
+	zipf->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+	zipf->halfPowTheta = zeta2;
+	return RC_OK;
+}
+
+// Returns the next value; 0 is the most frequent, then 1, and so on
+int
+zipfNext (ZipfGenerator *zipf, BenchRng *rng)
+{
+	double u = benchRngDouble(rng);
+	double uz = u * zipf->zetan;
+
+	if (uz < 1.0)
+		return 0;
+	if (uz < zipf->halfPowTheta)
+		return 1;
+
+	int value = (int) (zipf->n * pow(zipf->eta * u - zipf->eta + 1.0, zipf->alpha));
+	return value < zipf->n ? value : zipf->n - 1;
+}
+
+// Returns a monotonic timestamp in seconds
+double
+benchSeconds (void)
+{
+	return latencyNow() / 1e9;
+}
+
+void
+benchReportInit (BenchReport *report, const char *suite)
+{
+	report->suite = suite;
+	report->results = NULL;
+	report->numResults = 0;
+	report->capacity = 0;
+	memset(&report->counters, 0, sizeof(BenchCounters));
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+		report->counters.fds[c] = -1;
+}
+
+#ifdef __linux__
+// Opens one stopped counter for the calling thread, counting user space only
+static int
+openCounter (BenchCounter counter)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.type = PERF_TYPE_HARDWARE;
+	switch (counter)
+	{
+		case BENCH_CYCLES:
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case BENCH_INSTRUCTIONS:
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case BENCH_LLC_MISSES:
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		case BENCH_BRANCH_MISSES:
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		case BENCH_DTLB_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+					| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		default:
+			return -1;
+	}
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+#endif
+
+/*
+ * Opens the hardware counters of the calling thread, so every later phase
+ * between benchPhaseStart and benchPhaseStop reports them with its result.
+ * Counters the kernel or CPU does not offer (no PMU in a VM, a restrictive
+ * perf_event_paranoid, a non-Linux build) are left out.
+ *
+ * Returns the number of counters opened, 0 if none is available.
+ */
+int
+benchCountersEnable (BenchReport *report)
+{
+	int opened = 0;
+
+#ifdef __linux__
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+	{
+		if (report->counters.fds[c] == -1)
+			report->counters.fds[c] = openCounter((BenchCounter) c);
+		if (report->counters.fds[c] != -1)
+			opened++;
+	}
+#endif
+	return opened;
+}
+
+// Resets and starts every open counter
+void
+benchPhaseStart (BenchReport *report)
+{
+#ifdef __linux__
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+	{
+		int fd = report->counters.fds[c];
+		if (fd == -1)
+			continue;
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#else
+	(void) report;
+#endif
+}
+
+/*
+ * Stops every open counter and keeps its count for the next result added to
+ * the report. Counts of multiplexed counters are scaled to the whole phase.
+ */
+void
+benchPhaseStop (BenchReport *report)
+{
+#ifdef __linux__
+	BenchCounters *counters = &report->counters;
+
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+	{
+		uint64_t data[3];  // value, time enabled, time running
+		int fd = counters->fds[c];
+
+		counters->valid[c] = false;
+		if (fd == -1)
+			continue;
+		ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(fd, data, sizeof(data)) != sizeof(data) || data[2] == 0)
+			continue;
+		counters->values[c] = data[2] < data[1]
+				? (uint64_t) ((double) data[0] * data[1] / data[2])
+				: data[0];
+		counters->valid[c] = true;
+		counters->measured = true;
+	}
+#else
+	(void) report;
+#endif
+}
+
+const char *
+benchCounterName (BenchCounter counter)
+{
+	if (counter >= 0 && counter < BENCH_NUM_COUNTERS)
+		return benchCounterNames[counter];
+	return "unknown";
+}
+
+// Appends an empty result to the report, or returns NULL if out of memory
+static BenchResult *
+newResult (BenchReport *report, const char *name, long ops, double seconds)
+{
+	if (report->numResults == report->capacity)
+	{
+		int capacity = report->capacity ? 2 * report->capacity : 16;
+		BenchResult *results = realloc(report->results, capacity * sizeof(BenchResult));
+		if (results == NULL)
+			return NULL;
+		report->results = results;
+		report->capacity = capacity;
+	}
+
+	BenchResult *result = &report->results[report->numResults++];
+	snprintf(result->name, BENCH_NAME_LENGTH, "%s", name);
+	result->ops = ops;
+	result->pages = -1;
+	result->seconds = seconds;
+	result->hitRatio = -1;
+	result->p50Micros = -1;
+	result->p99Micros = -1;
+	result->p999Micros = -1;
+
+	// Attach the counts of the phase that just ended
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+	{
+		result->hasCounter[c] = report->counters.measured && report->counters.valid[c];
+		result->counters[c] = result->hasCounter[c] ? report->counters.values[c] : 0;
+	}
+	report->counters.measured = false;
+	return result;
+}
+
+// Prints one result as a table row on stdout
+static void
+printResult (BenchResult *result)
+{
+	printf("BENCH %-36s %10ld ops %10.4f s %14.1f ops/s", result->name, result->ops, result->seconds,
+			result->seconds > 0 ? result->ops / result->seconds : 0.0);
+	if (result->hitRatio >= 0)
+		printf("  hit ratio %.4f", result->hitRatio);
+	if (result->p50Micros >= 0)
+		printf("  p50 %.1f us  p99 %.1f us  p99.9 %.1f us",
+				result->p50Micros, result->p99Micros, result->p999Micros);
+	if (result->pages >= 0)
+		printf("  %ld pages", result->pages);
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+	{
+		if (result->hasCounter[c] && result->ops > 0)
+			printf("  %s/op %.2f", benchCounterNames[c], (double) result->counters[c] / result->ops);
+		if (result->hasCounter[c] && result->pages > 0)
+			printf("  %s/page %.2f", benchCounterNames[c], (double) result->counters[c] / result->pages);
+	}
+	if (result->hasCounter[BENCH_CYCLES] && result->hasCounter[BENCH_INSTRUCTIONS] && result->counters[BENCH_CYCLES] > 0)
+		printf("  ipc %.2f", (double) result->counters[BENCH_INSTRUCTIONS] / result->counters[BENCH_CYCLES]);
+	printf("\n");
+}
+
+/*
+ * Appends one result to the report and prints it as a table row on stdout.
+ */
+void
+benchReportAdd (BenchReport *report, const char *name, long ops, double seconds, double hitRatio)
+{
+	benchReportAddPages(report, name, ops, seconds, hitRatio, -1);
+}
+
+/*
+ * Appends one result that also counts the pages pinned during the phase, so
+ * counters are reported per page as well as per operation.
+ */
+void
+benchReportAddPages (BenchReport *report, const char *name, long ops, double seconds, double hitRatio,
+		long pages)
+{
+	BenchResult *result = newResult(report, name, ops, seconds);
+	if (result == NULL)
+		return;
+	result->hitRatio = hitRatio;
+	result->pages = pages;
+	printResult(result);
+}
+
+/*
+ * Appends one result with latency percentiles taken from a histogram.
+ */
+void
+benchReportAddLatency (BenchReport *report, const char *name, long ops, double seconds,
+		const LatencyHistogram *histogram)
+{
+	BenchResult *result = newResult(report, name, ops, seconds);
+	if (result == NULL)
+		return;
+	if (histogram->count > 0)
+	{
+		result->p50Micros = latencyPercentile(histogram, 50.0) / 1000.0;
+		result->p99Micros = latencyPercentile(histogram, 99.0) / 1000.0;
+		result->p999Micros = latencyPercentile(histogram, 99.9) / 1000.0;
+	}
+	printResult(result);
+}
+
+/*
+ * Writes every result as JSON, together with the build settings that affect
+ * timings, so runs of different builds can be compared.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_OPEN_FAILED or RC_WRITE_FAILED otherwise.
+ */
+RC
+benchReportWriteJson (BenchReport *report, const char *fileName)
+{
+	FILE *file = fopen(fileName, "w");
+	if (file == NULL)
+		return RC_FILE_OPEN_FAILED;
+
+	fprintf(file, "{\n  \"suite\": \"%s\",\n", report->suite);
+	fprintf(file, "  \"build\": {\"page_size\": %d, \"trace_level\": %d, \"latency_histograms\": %d, \"latch_profiling\": %d},\n",
+			PAGE_SIZE, TRACE_LEVEL, LATENCY_HISTOGRAMS, LATCH_PROFILING);
+	fprintf(file, "  \"results\": [\n");
+	for (int i = 0; i < report->numResults; i++)
+	{
+		BenchResult *result = &report->results[i];
+		fprintf(file, "    {\"name\": \"%s\", \"ops\": %ld, \"seconds\": %.6f, \"ops_per_sec\": %.1f",
+				result->name, result->ops, result->seconds,
+				result->seconds > 0 ? result->ops / result->seconds : 0.0);
+		if (result->pages >= 0)
+			fprintf(file, ", \"pages\": %ld", result->pages);
+		if (result->hitRatio >= 0)
+			fprintf(file, ", \"hit_ratio\": %.6f", result->hitRatio);
+		if (result->p50Micros >= 0)
+			fprintf(file, ", \"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f",
+					result->p50Micros, result->p99Micros, result->p999Micros);
+		for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+		{
+			if (!result->hasCounter[c])
+				continue;
+			fprintf(file, ", \"%s\": %llu, \"%s_per_op\": %.4f",
+					benchCounterNames[c], (unsigned long long) result->counters[c], benchCounterNames[c],
+					result->ops > 0 ? (double) result->counters[c] / result->ops : 0.0);
+			if (result->pages >= 0)
+				fprintf(file, ", \"%s_per_page\": %.4f", benchCounterNames[c],
+						result->pages > 0 ? (double) result->counters[c] / result->pages : 0.0);
+		}
+		fprintf(file, "}%s\n", i + 1 < report->numResults ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+
+	if (fclose(file) != 0)
+		return RC_WRITE_FAILED;
+	return RC_OK;
+}
+
+void
+benchReportFree (BenchReport *report)
+{
+	free(report->results);
+	report->results = NULL;
+#ifdef __linux__
+	for (int c = 0; c < BENCH_NUM_COUNTERS; c++)
+	{
+		if (report->counters.fds[c] != -1)
+			close(report->counters.fds[c]);
+		report->counters.fds[c] = -1;
+	}
+#endif
+	report->numResults = 0;
+	report->capacity = 0;
+}
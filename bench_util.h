@@ -0,0 +1,102 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "dberror.h"
+#include "latency.h"
+
+/************************************************************
+ *                    random numbers                        *
+ ************************************************************/
+// Small deterministic generator so runs are repeatable across libc versions
+typedef struct BenchRng {
+	uint64_t state;
+} BenchRng;
+
+// Zipfian page or key generator over [0, n), as in Gray et al. "Quickly
+// generating billion-record synthetic databases"; theta 0.99 is the YCSB default.
+typedef struct ZipfGenerator {
+	int n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+	double halfPowTheta;
+} ZipfGenerator;
+
+/************************************************************
+ *                    hardware counters                     *
+ ************************************************************/
+// Counted around each benchmark phase when enabled with benchCountersEnable
+typedef enum BenchCounter {
+	BENCH_CYCLES = 0,
+	BENCH_INSTRUCTIONS = 1,
+	BENCH_LLC_MISSES = 2,
+	BENCH_BRANCH_MISSES = 3,
+	BENCH_DTLB_MISSES = 4,
+	BENCH_NUM_COUNTERS
+} BenchCounter;
+
+typedef struct BenchCounters {
+	int fds[BENCH_NUM_COUNTERS];            // perf event per counter, -1 if unavailable
+	uint64_t values[BENCH_NUM_COUNTERS];    // counts of the last finished phase
+	bool valid[BENCH_NUM_COUNTERS];         // counter ran during that phase
+	bool measured;                          // values not yet attached to a result
+} BenchCounters;
+
+/************************************************************
+ *                    results                               *
+ ************************************************************/
+#define BENCH_NAME_LENGTH 64
+
+typedef struct BenchResult {
+	char name[BENCH_NAME_LENGTH];
+	long ops;          // operations of the phase: page pins, records or rows
+	long pages;        // pages pinned during the phase, or -1 if not counted
+	double seconds;
+	double hitRatio;   // buffer pool hit ratio, or -1 if not applicable
+	double p50Micros;  // latency percentiles, or -1 if not measured
+	double p99Micros;
+	double p999Micros;
+	bool hasCounter[BENCH_NUM_COUNTERS];
+	uint64_t counters[BENCH_NUM_COUNTERS];  // totals over the phase
+} BenchResult;
+
+typedef struct BenchReport {
+	const char *suite;
+	BenchResult *results;
+	int numResults;
+	int capacity;
+	BenchCounters counters;
+} BenchReport;
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+extern void benchRngSeed (BenchRng *rng, uint64_t seed);
+extern uint64_t benchRngNext (BenchRng *rng);
+extern double benchRngDouble (BenchRng *rng);
+extern int benchRngRange (BenchRng *rng, int n);
+
+extern RC zipfInit (ZipfGenerator *zipf, int n, double theta);
+extern int zipfNext (ZipfGenerator *zipf, BenchRng *rng);
+
+extern double benchSeconds (void);
+
+extern void benchReportInit (BenchReport *report, const char *suite);
+extern void benchReportAdd (BenchReport *report, const char *name, long ops, double seconds, double hitRatio);
+extern void benchReportAddPages (BenchReport *report, const char *name, long ops, double seconds, double hitRatio,
+		long pages);
+extern void benchReportAddLatency (BenchReport *report, const char *name, long ops, double seconds,
+		const LatencyHistogram *histogram);
+extern int benchCountersEnable (BenchReport *report);
+extern void benchPhaseStart (BenchReport *report);
+extern void benchPhaseStop (BenchReport *report);
+extern const char *benchCounterName (BenchCounter counter);
+extern RC benchReportWriteJson (BenchReport *report, const char *fileName);
+extern void benchReportFree (BenchReport *report);
+
+#endif // BENCH_UTIL_H
@@ -1,15 +1,41 @@
 #include "buffer_mgr.h"
+#include "latency.h"
+#include "metrics.h"
 #include "stdlib.h"
+#include <string.h>
 #include <unistd.h>
 
 int writtenToDisk = 0;
 int readFromDisk = 0;
 int lruCounter = 0;
+unsigned int frameStampCounter = 0;
 bool isInitialized_bp = false;
 
 int active_threads = 0;
 bool buffer_pool_shutting_down = false;
 
+// Residency snapshots live next to the page file, e.g. "table.bpsnap"
+#define RESIDENCY_SNAPSHOT_SUFFIX ".bpsnap"
+#define RESIDENCY_SNAPSHOT_MAGIC 0x4E535042
+#define RESIDENCY_SNAPSHOT_VERSION 2
+
+// One resident page as recorded in a residency snapshot
+typedef struct ResidencyEntry {
+    PageNumber pageNumber;
+    int lruOrder;
+    int refCount;
+    int history[BM_LRU_K_MAX];
+} ResidencyEntry;
+
+static void loadResidencySnapshot(BM_BufferPool *const bm);
+static RC writeResidencySnapshot(BM_BufferPool *const bm);
+
+// Adds a pin at the frame's current lruOrder to its LRU-K history
+static inline void noteReference(Frames *frame) {
+    memmove(&frame->history[1], &frame->history[0], sizeof(int) * (BM_LRU_K_MAX - 1));
+    frame->history[0] = frame->lruOrder;
+}
+
 // Global mutex lock for buffer pool initialization
 pthread_mutex_t buffer_pool_init_mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t bp_unique_init_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -89,7 +115,23 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
         frames[i].dirty = false;
         frames[i].fix_cnt = 0;
         frames[i].lruOrder = 0;
+        frames[i].refCount = 0;
+        memset(frames[i].history, 0, sizeof(frames[i].history));
+        frames[i].stamp = 0;
         createLatch(&(frames->pageLatches[i]));
+        nameLatch(&(frames->pageLatches[i]), "pool frame %d", i);
+    }
+
+    // Keep the page file open for the lifetime of the pool
+    if (openPageFile((char *) pageFileName, &bm->fileHandle) != RC_OK) {
+        for (int i = 0; i < numPages; i++) {
+            free(frames[i].memPage);
+            destroyLatch(&(frames->pageLatches[i]));
+        }
+        free(frames->pageLatches);
+        free(bm->mgmtData);
+        pthread_mutex_unlock(&bp_unique_init_mutex);
+        return RC_FILE_NOT_FOUND;
     }
 
     int *data = (int *)stratData;
@@ -97,6 +139,8 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
         // Use the value of the strategy-specific data
         bm->stratParam = *data;
         // Proceed with initializing the buffer pool using the value
+    } else {
+        bm->stratParam = 0;
     }
 
     // Initialize other properties of the buffer pool
@@ -104,9 +148,16 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
     bm->numPages = numPages;
     bm->strategy = strategy;
 
+    bm->persistResidency = false;
+    bm->pageTrace = NULL;
+    memset(&bm->stats, 0, sizeof(BM_Stats));
+
     writtenToDisk = 0;
     readFromDisk = 0;
 
+    // Warm the pool from the previous run before serving any request
+    loadResidencySnapshot(bm);
+
     printf("Buffer Pool has initialized.\n");
     isInitialized_bp=true;
 
@@ -134,6 +185,9 @@ RC shutdownBufferPool(BM_BufferPool *const bm) {
         return RC_BP_SHUNTDOWN_ERROR;
     }
 
+    // Stop metrics snapshots from reading the pool before it is freed
+    metricsForgetPool(bm);
+
     // Acquire the global mutex lock
     pthread_mutex_lock(&buffer_pool_init_mutex);
 
@@ -150,6 +204,13 @@ RC shutdownBufferPool(BM_BufferPool *const bm) {
     // Write dirty page back to disk
     forceFlushPool(bm);
 
+    // Record what was resident so the next initBufferPool can warm up
+    if (bm->persistResidency) {
+        writeResidencySnapshot(bm);
+    }
+    disablePageTrace(bm);
+    closePageFile(&bm->fileHandle);
+
     // Now free the memory for each page frame
     for (int i = 0; i < bm->numPages; i++) {
         if (frames[i].memPage != NULL) {
@@ -182,14 +243,30 @@ RC shutdownBufferPool(BM_BufferPool *const bm) {
     return RC_OK;
 }
 
+// A dirty frame waiting to be written back, keyed by its page number
+typedef struct FlushEntry {
+    PageNumber pageNum;
+    int frameIndex;
+} FlushEntry;
+
+// Orders flush entries by page number so contiguous pages can be merged
+static int compareFlushEntryByPage(const void *a, const void *b) {
+    const FlushEntry *left = (const FlushEntry *) a;
+    const FlushEntry *right = (const FlushEntry *) b;
+    return left->pageNum - right->pageNum;
+}
+
 /*
  * Writes all dirty pages with a fix count of 0 from the buffer pool to disk.
+ * The dirty frames are collected and sorted by page number, and every run of
+ * contiguous pages is written with a single vectored write through one file
+ * handle. Pinned pages are skipped and stay dirty.
  *
  * Parameters:
  * - bm: Pointer to the buffer pool structure.
  *
  * Returns:
- * - RC_OK if all dirty pages are successfully written to disk, otherwise an error code.
+ * - RC_OK if every unpinned dirty page was written to disk, otherwise an error code.
  */
 RC forceFlushPool(BM_BufferPool *const bm) {
     printf("Forcing flush the Buffer Pool.\n");
@@ -199,35 +276,653 @@ RC forceFlushPool(BM_BufferPool *const bm) {
 
     Frames *frames = (Frames *) bm->mgmtData;
     int numPages = bm->numPages;
-    int check_error = 0;
 
-    // Check for pinned pages
-    for (int i = 0; i< numPages; i++) {
-        if (frames[i].dirty == true && frames[i].fix_cnt == 0) {
-            // Acquire a latch to ensure exclusive access to the memory page
-            lockLatchForWrite(&(frames->pageLatches[i]));
+    // Collect the dirty pages nobody is using
+    FlushEntry entries[numPages];
+    int numDirty = 0;
+    for (int i = 0; i < numPages; i++) {
+        if (frames[i].dirty == true && frames[i].fix_cnt == 0 && frames[i].pageNumber != NO_PAGE) {
+            entries[numDirty].pageNum = frames[i].pageNumber;
+            entries[numDirty].frameIndex = i;
+            numDirty++;
+        }
+    }
+
+    if (numDirty == 0) {
+        return RC_OK;
+    }
 
-            SM_FileHandle fHandle;
-            openPageFile(bm->pageFile, &fHandle);
-            writeBlock(frames[i].pageNumber, &fHandle, frames[i].memPage);
-            closePageFile(&fHandle);
-            frames[i].dirty = false;
-            writtenToDisk++;
-            releaseLatchAfterWrite(&(frames->pageLatches[i]));
+    qsort(entries, numDirty, sizeof(FlushEntry), compareFlushEntryByPage);
+
+    // Write each run of contiguous pages with one call
+    RC rc = RC_OK;
+    SM_PageHandle memPages[numDirty];
+    int runStart = 0;
+    while (runStart < numDirty) {
+        int runEnd = runStart + 1;
+        while (runEnd < numDirty && entries[runEnd].pageNum == entries[runEnd - 1].pageNum + 1) {
+            runEnd++;
+        }
+
+        for (int i = runStart; i < runEnd; i++) {
+            lockLatchForWrite(&(frames->pageLatches[entries[i].frameIndex]));
+            memPages[i - runStart] = frames[entries[i].frameIndex].memPage;
+        }
+
+        if (writeBlocks(entries[runStart].pageNum, runEnd - runStart, &bm->fileHandle, memPages) == RC_OK) {
+            for (int i = runStart; i < runEnd; i++) {
+                frames[entries[i].frameIndex].dirty = false;
+                writtenToDisk++;
+                bm->stats.writes++;
+                bm->stats.backgroundWritebacks++;
+            }
         } else {
-            check_error++;
+            rc = RC_BP_FLUSHPOOL_FAILED;
         }
-        if (frames[i].fix_cnt != 0) {
-            return RC_BP_FLUSHPOOL_FAILED;
+
+        for (int i = runStart; i < runEnd; i++) {
+            releaseLatchAfterWrite(&(frames->pageLatches[entries[i].frameIndex]));
         }
+        runStart = runEnd;
     }
 
-    if (check_error == numPages) {
-        return RC_BP_FLUSHPOOL_FAILED;
-    } else {
+    if (rc == RC_OK) {
         printf("Finished force flush pool.\n");
+    }
+    return rc;
+}
+
+// Recency of a frame, used to rank eviction candidates when the pool shrinks
+typedef struct FrameOrder {
+    int lruOrder;
+    int index;
+} FrameOrder;
+
+// Orders frames from most to least recently used
+static int compareFrameOrderDesc(const void *a, const void *b) {
+    const FrameOrder *left = (const FrameOrder *) a;
+    const FrameOrder *right = (const FrameOrder *) b;
+    return right->lruOrder - left->lruOrder;
+}
+
+/*
+ * Resizes a live buffer pool to the specified number of page frames.
+ * Growing the pool appends empty frames. Shrinking the pool keeps every pinned frame
+ * and the most recently used unpinned frames; the remaining frames are written back
+ * if dirty and evicted. Pinned frames keep their page memory, so page handles
+ * obtained before the resize stay valid. If a write-back fails, the pool is left
+ * as it was; pages already written back stay resident, now clean.
+ *
+ * Parameters:
+ * - bm: Pointer to the buffer pool structure to be resized.
+ * - newNumPages: New number of page frames in the buffer pool.
+ *
+ * Returns:
+ * - RC_OK if the buffer pool was resized.
+ * - RC_BP_RESIZE_ERROR if the pool is not initialized, the new size is invalid,
+ *   more than newNumPages frames are pinned, or memory allocation fails.
+ * - Any error of writeBlock if a dirty page cannot be written back.
+ */
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages) {
+    printf("Resizing the Buffer Pool.\n");
+    if (isInitialized_bp == false || newNumPages <= 0) {
+        return RC_BP_RESIZE_ERROR;
+    }
+
+    pthread_mutex_lock(&buffer_pool_init_mutex);
+
+    Frames *frames = (Frames *) bm->mgmtData;
+    int oldNumPages = bm->numPages;
+
+    // Pinned frames can never be evicted, so they bound how far the pool can shrink
+    int numPinned = 0, numResident = 0;
+    for (int i = 0; i < oldNumPages; i++) {
+        if (frames[i].fix_cnt > 0) {
+            numPinned++;
+        } else if (frames[i].pageNumber != NO_PAGE) {
+            numResident++;
+        }
+    }
+    if (numPinned > newNumPages) {
+        pthread_mutex_unlock(&buffer_pool_init_mutex);
+        return RC_BP_RESIZE_ERROR;
+    }
+
+    // Unpinned resident pages fill the free slots first, the rest get fresh page memory
+    int numUnpinnedKept = newNumPages - numPinned < numResident ? newNumPages - numPinned : numResident;
+    int numFresh = newNumPages - numPinned - numUnpinnedKept;
+
+    Frames *newFrames = malloc(sizeof(Frames) * newNumPages);
+    Latch *newLatches = malloc(sizeof(Latch) * newNumPages);
+    FrameOrder *candidates = malloc(sizeof(FrameOrder) * oldNumPages);
+    SM_PageHandle *freshPages = calloc(numFresh > 0 ? numFresh : 1, sizeof(SM_PageHandle));
+    bool allocated = newFrames != NULL && newLatches != NULL && candidates != NULL && freshPages != NULL;
+    for (int i = 0; allocated && i < numFresh; i++) {
+        freshPages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+        allocated = freshPages[i] != NULL;
+    }
+    if (!allocated) {
+        for (int i = 0; freshPages != NULL && i < numFresh; i++) {
+            free(freshPages[i]);
+        }
+        free(freshPages);
+        free(newFrames);
+        free(newLatches);
+        free(candidates);
+        pthread_mutex_unlock(&buffer_pool_init_mutex);
+        return RC_BP_RESIZE_ERROR;
+    }
+
+    // Rank the unpinned resident pages by recency
+    int numCandidates = 0;
+    for (int i = 0; i < oldNumPages; i++) {
+        if (frames[i].fix_cnt == 0 && frames[i].pageNumber != NO_PAGE) {
+            candidates[numCandidates].lruOrder = frames[i].lruOrder;
+            candidates[numCandidates].index = i;
+            numCandidates++;
+        }
+    }
+    qsort(candidates, numCandidates, sizeof(FrameOrder), compareFrameOrderDesc);
+
+    // Write back the dirty pages that do not fit before changing anything, so a failed write loses nothing
+    for (int c = numUnpinnedKept; c < numCandidates; c++) {
+        Frames *frame = &frames[candidates[c].index];
+        if (!frame->dirty) {
+            continue;
+        }
+        RC rc = writeBlock(frame->pageNumber, &bm->fileHandle, frame->memPage);
+        if (rc != RC_OK) {
+            for (int i = 0; i < numFresh; i++) {
+                free(freshPages[i]);
+            }
+            free(freshPages);
+            free(newFrames);
+            free(newLatches);
+            free(candidates);
+            pthread_mutex_unlock(&buffer_pool_init_mutex);
+            return rc;
+        }
+        frame->dirty = false;
+        writtenToDisk++;
+        bm->stats.writes++;
+        bm->stats.backgroundWritebacks++;
+    }
+
+    // Pinned frames survive first, in their current order, then the most recently used pages
+    int kept = 0;
+    for (int i = 0; i < oldNumPages; i++) {
+        if (frames[i].fix_cnt > 0) {
+            newFrames[kept++] = frames[i];
+        }
+    }
+    for (int c = 0; c < numCandidates; c++) {
+        Frames *frame = &frames[candidates[c].index];
+        if (c < numUnpinnedKept) {
+            newFrames[kept++] = *frame;
+            continue;
+        }
+
+        // No room left for this page, it was written back above
+        bm->stats.resizeEvictions++;
+        free(frame->memPage);
+        frame->memPage = NULL;
+    }
+
+    // Empty frames carry no state, release their memory
+    for (int i = 0; i < oldNumPages; i++) {
+        if (frames[i].fix_cnt == 0 && frames[i].pageNumber == NO_PAGE) {
+            free(frames[i].memPage);
+        }
+    }
+
+    // Fill the remaining slots with fresh empty frames
+    for (int i = kept; i < newNumPages; i++) {
+        newFrames[i].memPage = freshPages[i - kept];
+        newFrames[i].pageNumber = NO_PAGE;
+        newFrames[i].dirty = false;
+        newFrames[i].fix_cnt = 0;
+        newFrames[i].lruOrder = 0;
+        newFrames[i].refCount = 0;
+        memset(newFrames[i].history, 0, sizeof(newFrames[i].history));
+        newFrames[i].stamp = 0;
+    }
+
+    // Latches are rebuilt for the new frame layout
+    for (int i = 0; i < oldNumPages; i++) {
+        destroyLatch(&(frames->pageLatches[i]));
+    }
+    free(frames->pageLatches);
+    for (int i = 0; i < newNumPages; i++) {
+        createLatch(&newLatches[i]);
+        nameLatch(&newLatches[i], "pool frame %d", i);
+    }
+    newFrames->pageLatches = newLatches;
+
+    free(candidates);
+    free(freshPages);
+    metricsLockSources();
+    free(frames);
+    bm->mgmtData = newFrames;
+    bm->numPages = newNumPages;
+    metricsUnlockSources();
+
+    pthread_mutex_unlock(&buffer_pool_init_mutex);
+
+    printf("Buffer Pool resized from %d to %d frames.\n", oldNumPages, newNumPages);
+    return RC_OK;
+}
+
+/*
+ * Drops the pages at and after numPages from the pool and shortens the page
+ * file to numPages pages. Dirty pages among them are discarded, not written
+ * back, since their blocks no longer exist.
+ *
+ * Parameters:
+ * - bm: Pointer to the buffer pool structure.
+ * - numPages: Number of pages the page file keeps.
+ *
+ * Returns:
+ * - RC_OK if the pages were dropped and the file shortened.
+ * - RC_BP_TRUNCATE_ERROR if the pool is not initialized or one of the pages is pinned.
+ * - Any error of truncatePageFile.
+ */
+RC truncatePool(BM_BufferPool *const bm, const int numPages) {
+    if (isInitialized_bp == false || numPages < 0) {
+        return RC_BP_TRUNCATE_ERROR;
+    }
+
+    pthread_mutex_lock(&buffer_pool_init_mutex);
+    Frames *frames = (Frames *) bm->mgmtData;
+
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].pageNumber >= numPages && frames[i].fix_cnt > 0) {
+            pthread_mutex_unlock(&buffer_pool_init_mutex);
+            return RC_BP_TRUNCATE_ERROR;
+        }
+    }
+
+    // The frames become empty; their stamps stay, so handles to the dropped pages fail the hint check
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].pageNumber >= numPages) {
+            frames[i].pageNumber = NO_PAGE;
+            frames[i].dirty = false;
+            frames[i].refCount = 0;
+        }
+    }
+
+    RC rc = truncatePageFile(numPages, &bm->fileHandle);
+    pthread_mutex_unlock(&buffer_pool_init_mutex);
+    return rc;
+}
+
+// Builds the residency snapshot file name for a page file
+static char *residencySnapshotName(const char *const pageFileName) {
+    size_t length = strlen(pageFileName) + strlen(RESIDENCY_SNAPSHOT_SUFFIX) + 1;
+    char *name = malloc(length);
+    if (name != NULL) {
+        snprintf(name, length, "%s%s", pageFileName, RESIDENCY_SNAPSHOT_SUFFIX);
+    }
+    return name;
+}
+
+// Orders snapshot entries from most to least recently used
+static int compareResidencyByRecency(const void *a, const void *b) {
+    const ResidencyEntry *left = (const ResidencyEntry *) a;
+    const ResidencyEntry *right = (const ResidencyEntry *) b;
+    return right->lruOrder - left->lruOrder;
+}
+
+// Orders recency stamps from oldest to newest
+static int compareStamps(const void *a, const void *b) {
+    return *(const int *) a - *(const int *) b;
+}
+
+// Returns the position of the first stamp not older than stamp in a sorted array
+static int stampRank(const int *stamps, int numStamps, int stamp) {
+    int low = 0;
+    int high = numStamps;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (stamps[mid] < stamp) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Orders snapshot entries by page number so reloads read the file sequentially
+static int compareResidencyByPage(const void *a, const void *b) {
+    const ResidencyEntry *left = (const ResidencyEntry *) a;
+    const ResidencyEntry *right = (const ResidencyEntry *) b;
+    return left->pageNumber - right->pageNumber;
+}
+
+/*
+ * Enables or disables writing a residency snapshot when the pool shuts down.
+ * The snapshot lists the resident pages with their recency and frequency, and is
+ * consumed by the next initBufferPool on the same page file.
+ *
+ * Parameters:
+ * - bm: Pointer to the buffer pool structure.
+ * - enable: true to write a snapshot on shutdown, false otherwise.
+ *
+ * Returns:
+ * - RC_OK on success, RC_BP_INIT_ERROR if the pool is not initialized.
+ */
+RC enableResidencySnapshot(BM_BufferPool *const bm, bool enable) {
+    if (isInitialized_bp == false || bm->mgmtData == NULL) {
+        return RC_BP_INIT_ERROR;
+    }
+    bm->persistResidency = enable;
+    return RC_OK;
+}
+
+/*
+ * Removes the residency snapshot of a page file, if any.
+ * Called when the page file itself is destroyed so a new file with the same
+ * name does not inherit a stale page list.
+ *
+ * Parameters:
+ * - pageFileName: Name of the page file whose snapshot should be removed.
+ *
+ * Returns:
+ * - RC_OK whether or not a snapshot existed, RC_MALLOC_ERROR on allocation failure.
+ */
+RC discardResidencySnapshot(const char *const pageFileName) {
+    char *snapshotName = residencySnapshotName(pageFileName);
+    if (snapshotName == NULL) {
+        return RC_MALLOC_ERROR;
+    }
+    remove(snapshotName);
+    free(snapshotName);
+    return RC_OK;
+}
+
+/*
+ * Starts appending every pin and unpin of the pool to a page reference trace.
+ * The file is truncated and begins with a BM_TraceHeader; each event is a
+ * BM_TraceEvent with its time, page, kind and the frame's dirty flag. Events
+ * go through stdio buffering, so they reach the file at the latest when the
+ * trace is disabled or the pool shuts down.
+ *
+ * Parameters:
+ * - bm: Pointer to the buffer pool structure.
+ * - traceFileName: File to write the trace to.
+ *
+ * Returns:
+ * - RC_OK on success, RC_BP_INIT_ERROR if the pool is not initialized,
+ *   RC_FILE_OPEN_FAILED or RC_WRITE_FAILED if the file cannot be created.
+ */
+RC enablePageTrace(BM_BufferPool *const bm, const char *const traceFileName) {
+    if (isInitialized_bp == false || bm->mgmtData == NULL) {
+        return RC_BP_INIT_ERROR;
+    }
+    disablePageTrace(bm);
+
+    FILE *trace = fopen(traceFileName, "wb");
+    if (trace == NULL) {
+        return RC_FILE_OPEN_FAILED;
+    }
+    BM_TraceHeader header = {BM_TRACE_MAGIC, BM_TRACE_VERSION};
+    if (fwrite(&header, sizeof(header), 1, trace) != 1) {
+        fclose(trace);
+        return RC_WRITE_FAILED;
+    }
+    bm->pageTrace = trace;
+    return RC_OK;
+}
+
+/*
+ * Stops page reference tracing and closes the trace file, if one is open.
+ *
+ * Parameters:
+ * - bm: Pointer to the buffer pool structure.
+ *
+ * Returns:
+ * - RC_OK on success, RC_WRITE_FAILED if buffered events could not be written.
+ */
+RC disablePageTrace(BM_BufferPool *const bm) {
+    if (bm->pageTrace == NULL) {
         return RC_OK;
     }
+    int result = fclose(bm->pageTrace);
+    bm->pageTrace = NULL;
+    return result == 0 ? RC_OK : RC_WRITE_FAILED;
+}
+
+/*
+ * Writes the resident page list of the pool to its snapshot file.
+ * The file holds a small header followed by one ResidencyEntry per resident frame.
+ *
+ * @param bm Buffer pool containing information about the buffer pool
+ * @return   RC_OK on success, or RC_WRITE_FAILED otherwise
+ */
+static RC writeResidencySnapshot(BM_BufferPool *const bm) {
+    Frames *frames = (Frames *) bm->mgmtData;
+    char *snapshotName = residencySnapshotName(bm->pageFile);
+    if (snapshotName == NULL) {
+        return RC_WRITE_FAILED;
+    }
+
+    FILE *file = fopen(snapshotName, "wb");
+    free(snapshotName);
+    if (file == NULL) {
+        return RC_WRITE_FAILED;
+    }
+
+    int count = 0;
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].pageNumber != NO_PAGE) {
+            count++;
+        }
+    }
+
+    int header[3] = { RESIDENCY_SNAPSHOT_MAGIC, RESIDENCY_SNAPSHOT_VERSION, count };
+    bool ok = fwrite(header, sizeof(int), 3, file) == 3;
+
+    for (int i = 0; ok && i < bm->numPages; i++) {
+        if (frames[i].pageNumber == NO_PAGE) {
+            continue;
+        }
+        ResidencyEntry entry = { frames[i].pageNumber, frames[i].lruOrder, frames[i].refCount, {0} };
+        memcpy(entry.history, frames[i].history, sizeof(entry.history));
+        ok = fwrite(&entry, sizeof(ResidencyEntry), 1, file) == 1;
+    }
+
+    if (fclose(file) != 0 || !ok) {
+        return RC_WRITE_FAILED;
+    }
+    printf("Wrote residency snapshot with %d pages.\n", count);
+    return RC_OK;
+}
+
+/*
+ * Reloads the pages listed in the pool's residency snapshot, if one exists.
+ * The most recently used pages that fit in the pool are read in page order, each
+ * contiguous run with a single multi-page read, and their relative recency,
+ * reference counts and LRU-K pin history are restored. The snapshot is consumed; any failure simply
+ * leaves the pool cold.
+ *
+ * @param bm Buffer pool containing information about the buffer pool
+ */
+static void loadResidencySnapshot(BM_BufferPool *const bm) {
+    Frames *frames = (Frames *) bm->mgmtData;
+    char *snapshotName = residencySnapshotName(bm->pageFile);
+    if (snapshotName == NULL) {
+        return;
+    }
+
+    FILE *file = fopen(snapshotName, "rb");
+    if (file == NULL) {
+        free(snapshotName);
+        return;
+    }
+
+    int header[3];
+    ResidencyEntry *entries = NULL;
+    int count = 0;
+    if (fread(header, sizeof(int), 3, file) == 3 && header[0] == RESIDENCY_SNAPSHOT_MAGIC
+        && header[1] == RESIDENCY_SNAPSHOT_VERSION && header[2] > 0) {
+        count = header[2];
+        entries = malloc(sizeof(ResidencyEntry) * count);
+        if (entries == NULL || fread(entries, sizeof(ResidencyEntry), count, file) != (size_t) count) {
+            count = 0;
+        }
+    }
+    fclose(file);
+    remove(snapshotName);
+    free(snapshotName);
+
+    if (count == 0) {
+        free(entries);
+        return;
+    }
+
+    // Drop pages that no longer exist in the file
+    int valid = 0;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].pageNumber >= 0 && entries[i].pageNumber < bm->fileHandle.totalNumPages) {
+            entries[valid++] = entries[i];
+        }
+    }
+
+    // Keep the hottest pages that fit
+    qsort(entries, valid, sizeof(ResidencyEntry), compareResidencyByRecency);
+    if (valid > bm->numPages) {
+        valid = bm->numPages;
+    }
+
+    // Renumber their recency and pin history in the current run, keeping the old order
+    int *stamps = malloc(sizeof(int) * (valid * (BM_LRU_K_MAX + 1) + 1));
+    if (stamps == NULL) {
+        free(entries);
+        return;
+    }
+    int numStamps = 0;
+    for (int i = 0; i < valid; i++) {
+        int depth = entries[i].refCount < BM_LRU_K_MAX ? entries[i].refCount : BM_LRU_K_MAX;
+        stamps[numStamps++] = entries[i].lruOrder;
+        for (int h = 0; h < depth; h++) {
+            stamps[numStamps++] = entries[i].history[h];
+        }
+    }
+    qsort(stamps, numStamps, sizeof(int), compareStamps);
+    for (int i = 0; i < valid; i++) {
+        int depth = entries[i].refCount < BM_LRU_K_MAX ? entries[i].refCount : BM_LRU_K_MAX;
+        entries[i].lruOrder = lruCounter + 1 + stampRank(stamps, numStamps, entries[i].lruOrder);
+        for (int h = 0; h < BM_LRU_K_MAX; h++) {
+            entries[i].history[h] = h < depth ? lruCounter + 1 + stampRank(stamps, numStamps, entries[i].history[h]) : 0;
+        }
+    }
+    lruCounter += numStamps;
+    free(stamps);
+
+    // Read back in page order, one multi-page read per contiguous run
+    qsort(entries, valid, sizeof(ResidencyEntry), compareResidencyByPage);
+    SM_PageHandle memPages[bm->numPages];
+    int loaded = 0;
+    int runStart = 0;
+    while (runStart < valid) {
+        int runEnd = runStart + 1;
+        while (runEnd < valid && entries[runEnd].pageNumber == entries[runEnd - 1].pageNumber + 1) {
+            runEnd++;
+        }
+
+        for (int i = runStart; i < runEnd; i++) {
+            memPages[i - runStart] = frames[i].memPage;
+        }
+        if (readBlocks(entries[runStart].pageNumber, runEnd - runStart, &bm->fileHandle, memPages) == RC_OK) {
+            for (int i = runStart; i < runEnd; i++) {
+                frames[i].pageNumber = entries[i].pageNumber;
+                frames[i].lruOrder = entries[i].lruOrder;
+                frames[i].refCount = entries[i].refCount;
+                memcpy(frames[i].history, entries[i].history, sizeof(frames[i].history));
+                frameStampCounter++;
+                frames[i].stamp = frameStampCounter;
+                readFromDisk++;
+                bm->stats.reads++;
+                loaded++;
+            }
+        }
+        runStart = runEnd;
+    }
+
+    free(entries);
+    printf("Warm restart reloaded %d pages.\n", loaded);
+}
+
+/*
+ * Fills a page handle for the page held in the given frame, including the frame
+ * hint that lets later calls on the same handle skip the frame lookup.
+ */
+static inline void setPageHandle(BM_PageHandle *const page, Frames *frames, int frameIndex) {
+    page->pageNum = frames[frameIndex].pageNumber;
+    page->data = frames[frameIndex].memPage;
+    page->frameIndex = frameIndex;
+    page->frameStamp = frames[frameIndex].stamp;
+}
+
+/*
+ * Appends a pin or unpin of the page held in a frame to the page reference
+ * trace, if tracing is enabled.
+ */
+static inline void tracePageRef(BM_BufferPool *const bm, Frames *frame, BM_TraceEventKind kind) {
+    if (bm->pageTrace == NULL) {
+        return;
+    }
+    BM_TraceEvent event = {latencyNow(), frame->pageNumber, (uint8_t) kind, frame->dirty, 0};
+    fwrite(&event, sizeof(event), 1, bm->pageTrace);
+}
+
+/*
+ * Accounts for one more pin on a frame that had the given fix count, tracking
+ * how many frames are pinned at once.
+ */
+static inline void notePinned(BM_BufferPool *const bm, int oldFixCount) {
+    if (oldFixCount == 0) {
+        bm->stats.pinnedFrames++;
+        if (bm->stats.pinnedFrames > bm->stats.peakPinnedFrames) {
+            bm->stats.peakPinnedFrames = bm->stats.pinnedFrames;
+        }
+    }
+}
+
+/*
+ * Checks whether the frame hint of a page handle still designates the frame
+ * holding the handle's page. Every page load gives its frame a new stamp, and
+ * stamp 0 is never handed out, so zeroed or stale handles fail the check.
+ */
+static inline bool frameHintValid(BM_BufferPool *const bm, Frames *frames, BM_PageHandle *const page) {
+    int index = page->frameIndex;
+    return index >= 0 && index < bm->numPages
+           && frames[index].stamp != 0
+           && frames[index].stamp == page->frameStamp
+           && frames[index].pageNumber == page->pageNum;
+}
+
+/*
+ * Finds the frame holding the page of a handle, going straight to the hinted
+ * frame when the hint is valid and falling back to a search otherwise.
+ *
+ * @return the frame index, or -1 if the page is not in the pool
+ */
+static int findFrame(BM_BufferPool *const bm, BM_PageHandle *const page) {
+    Frames *frames = (Frames *) bm->mgmtData;
+
+    if (frameHintValid(bm, frames, page)) {
+        return page->frameIndex;
+    }
+
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].pageNumber != NO_PAGE && frames[i].pageNumber == page->pageNum) {
+            page->frameIndex = i;
+            page->frameStamp = frames[i].stamp;
+            return i;
+        }
+    }
+    return -1;
 }
 
 /*
@@ -240,7 +935,7 @@ RC forceFlushPool(BM_BufferPool *const bm) {
  * @return       RC_OK on success, or an error code otherwise
  */
 RC FIFO (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
-    printf("Using FIFO strategy.\n");
+    TRACE_DEBUG(TE_PIN_MISS, pageNum, RS_FIFO);
     Frames *frames = (Frames *) bm->mgmtData;
     int FIFO_PageIndex;
     int check_error = 0;
@@ -252,25 +947,25 @@ RC FIFO (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pa
         if (frames[FIFO_PageIndex].fix_cnt == 0) {
             if (frames[FIFO_PageIndex].dirty) {
                 lockLatchForWrite(&(frames->pageLatches[FIFO_PageIndex]));
-                SM_FileHandle fHandle;
-                openPageFile(bm->pageFile, &fHandle);
-                writeBlock(frames[FIFO_PageIndex].pageNumber, &fHandle, frames[FIFO_PageIndex].memPage);
-                closePageFile(&fHandle);
+                writeBlock(frames[FIFO_PageIndex].pageNumber, &bm->fileHandle, frames[FIFO_PageIndex].memPage);
                 frames[FIFO_PageIndex].dirty = false;
                 writtenToDisk++;
+                bm->stats.writes++;
+                bm->stats.syncWritebacks++;
                 releaseLatchAfterWrite(&(frames->pageLatches[FIFO_PageIndex]));
             }
 
             // Read page from disk into a new frame
             lockLatchForRead(&(frames->pageLatches[FIFO_PageIndex]));
-            SM_FileHandle fHandle;
-            openPageFile(bm->pageFile, &fHandle);
-            ensureCapacity(pageNum, &fHandle);
-            readBlock(pageNum, &fHandle, frames[FIFO_PageIndex].memPage);
-            closePageFile(&fHandle);
+            ensureCapacity(pageNum + 1, &bm->fileHandle);
+            readBlock(pageNum, &bm->fileHandle, frames[FIFO_PageIndex].memPage);
             releaseLatchAfterRead(&(frames->pageLatches[FIFO_PageIndex]));
 
             readFromDisk++;
+            bm->stats.reads++;
+            bm->stats.misses++;
+            bm->stats.evictions[RS_FIFO]++;
+            notePinned(bm, 0);
 
             // Update frame information with the new page
             lruCounter++;
@@ -278,8 +973,11 @@ RC FIFO (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pa
             frames[FIFO_PageIndex].dirty = false;
             frames[FIFO_PageIndex].fix_cnt = 1;
             frames[FIFO_PageIndex].lruOrder = lruCounter;
-            page->pageNum = pageNum;
-            page->data = frames[FIFO_PageIndex].memPage;
+            frames[FIFO_PageIndex].refCount = 1;
+            noteReference(&frames[FIFO_PageIndex]);
+            frameStampCounter++;
+            frames[FIFO_PageIndex].stamp = frameStampCounter;
+            setPageHandle(page, frames, FIFO_PageIndex);
             break;
         } else {
             FIFO_PageIndex++;
@@ -294,51 +992,101 @@ RC FIFO (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pa
     return RC_OK;
 }
 
+// Returns the least recently used unpinned frame, or -1 if every frame is pinned
+static int lruVictim(BM_BufferPool *const bm) {
+    Frames *frames = (Frames *) bm->mgmtData;
+    int victim = -1;
+
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].fix_cnt == 0 && (victim == -1 || frames[i].lruOrder < frames[victim].lruOrder)) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+// History depth of an LRU-K pool, from stratParam
+static int lruKDepth(BM_BufferPool *const bm) {
+    if (bm->stratParam <= 0) {
+        return BM_LRU_K_DEFAULT;
+    }
+    return bm->stratParam < BM_LRU_K_MAX ? bm->stratParam : BM_LRU_K_MAX;
+}
+
+/*
+ * Returns the unpinned frame with the largest backward K-distance, the age of
+ * its page's K-th most recent pin, or -1 if every frame is pinned. Pages pinned
+ * fewer than K times since they were loaded have an infinite distance and go
+ * first, least recently used first.
+ */
+static int lruKVictim(BM_BufferPool *const bm) {
+    Frames *frames = (Frames *) bm->mgmtData;
+    int k = lruKDepth(bm);
+    int victim = -1;
+
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].fix_cnt > 0) {
+            continue;
+        }
+        if (victim == -1) {
+            victim = i;
+            continue;
+        }
+        bool shortHistory = frames[i].refCount < k;
+        bool victimShort = frames[victim].refCount < k;
+        if (shortHistory != victimShort) {
+            if (shortHistory) {
+                victim = i;
+            }
+        } else if (shortHistory ? frames[i].lruOrder < frames[victim].lruOrder
+                                : frames[i].history[k - 1] < frames[victim].history[k - 1]) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
 /*
  * LRU (Least Recently Used) page replacement strategy.
  * This function implements the LRU page replacement algorithm,
- * which selects the page that has not been used for the longest time for eviction.
+ * which selects the unpinned page that has not been used for the longest time for eviction.
  *
  * @param bm     Buffer pool containing information about the buffer pool
  * @param page   Pointer to the page to be replaced
- * @return       RC_OK on success, or an error code otherwise
+ * @return       RC_OK on success, or RC_BP_PIN_ERROR if every page is pinned
  */
 RC LRU (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
-    printf("Using LRU strategy.\n");
+    TRACE_DEBUG(TE_PIN_MISS, pageNum, RS_LRU);
     Frames *frames = (Frames *) bm->mgmtData;
-    int LRU_PageIndex = 0;
-    int comNum = frames[0].lruOrder;
 
     // Find the index of the least recently used page
-    for (int i = 1; i < bm->numPages; i++) {
-        if (frames[i].lruOrder < comNum) {
-            comNum = frames[i].lruOrder;
-            LRU_PageIndex = i;
-        }
+    int LRU_PageIndex = lruVictim(bm);
+    if (LRU_PageIndex == -1) {
+        return RC_BP_PIN_ERROR;
     }
 
     // Check if the least recently used page is dirty and write it back to disk
     if (frames[LRU_PageIndex].dirty) {
         lockLatchForWrite(&(frames->pageLatches[LRU_PageIndex]));
-        SM_FileHandle fHandle;
-        openPageFile(bm->pageFile, &fHandle);
-        writeBlock(frames[LRU_PageIndex].pageNumber, &fHandle, frames[LRU_PageIndex].memPage);
-        closePageFile(&fHandle);
+        writeBlock(frames[LRU_PageIndex].pageNumber, &bm->fileHandle, frames[LRU_PageIndex].memPage);
         frames[LRU_PageIndex].dirty = false;
         writtenToDisk++;
+        bm->stats.writes++;
+        bm->stats.syncWritebacks++;
         releaseLatchAfterWrite(&(frames->pageLatches[LRU_PageIndex]));
     }
 
     // Read the new page from disk into the selected frame
     lockLatchForRead(&(frames->pageLatches[LRU_PageIndex]));
-    SM_FileHandle fHandle;
-    openPageFile(bm->pageFile, &fHandle);
-    ensureCapacity(pageNum, &fHandle);
-    readBlock(pageNum, &fHandle, frames[LRU_PageIndex].memPage);
-    closePageFile(&fHandle);
+    ensureCapacity(pageNum + 1, &bm->fileHandle);
+    readBlock(pageNum, &bm->fileHandle, frames[LRU_PageIndex].memPage);
     releaseLatchAfterRead(&(frames->pageLatches[LRU_PageIndex]));
 
     readFromDisk++;
+    bm->stats.reads++;
+    bm->stats.misses++;
+    bm->stats.evictions[RS_LRU]++;
+    notePinned(bm, frames[LRU_PageIndex].fix_cnt);
 
     // Update frame information with the new page and its usage order
     lruCounter++;
@@ -346,101 +1094,57 @@ RC LRU (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pag
     frames[LRU_PageIndex].dirty = false;
     frames[LRU_PageIndex].fix_cnt = 1;
     frames[LRU_PageIndex].lruOrder = lruCounter;
-    page->pageNum = pageNum;
-    page->data = frames[LRU_PageIndex].memPage;
+    frames[LRU_PageIndex].refCount = 1;
+    noteReference(&frames[LRU_PageIndex]);
+    frameStampCounter++;
+    frames[LRU_PageIndex].stamp = frameStampCounter;
+    setPageHandle(page, frames, LRU_PageIndex);
 
     return RC_OK;
 }
 
-// Function to swap two elements
-void swap(int* a, int* b) {
-    int temp = *a;
-    *a = *b;
-    *b = temp;
-}
-
-// Function to partition the array and return the pivot index
-int partition(int arr[], int low, int high) {
-    int pivot = arr[high]; // Choose the rightmost element as the pivot
-    int i = low - 1; // Index of smaller element
-
-    for (int j = low; j < high; j++) {
-        // If current element is smaller than or equal to pivot
-        if (arr[j] <= pivot) {
-            i++; // Increment index of smaller element
-            swap(&arr[i], &arr[j]);
-        }
-    }
-    swap(&arr[i + 1], &arr[high]);
-    return i + 1;
-}
-
-// Quicksort function in ascending order
-void quickSort(int arr[], int low, int high) {
-    if (low < high) {
-        // Partition the array
-        int pi = partition(arr, low, high);
-
-        // Recursively sort elements before partition and after partition
-        quickSort(arr, low, pi - 1);
-        quickSort(arr, pi + 1, high);
-    }
-}
-
 /*
  * LRU-K (Least Recently Used with K-Value) page replacement strategy.
  * This function implements the LRU-K page replacement algorithm,
- * which selects the page that has not been used for the longest time within the last K references for eviction.
+ * which evicts the unpinned page whose K-th most recent pin is the oldest;
+ * K is the pool's stratParam.
  *
  * @param bm     Buffer pool containing information about the buffer pool
  * @param page   Pointer to the page to be replaced
- * @return       RC_OK on success, or an error code otherwise
+ * @return       RC_OK on success, or RC_BP_PIN_ERROR if every page is pinned
  */
 RC LRU_K (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum) {
-    printf("Using LRU strategy.\n");
+    TRACE_DEBUG(TE_PIN_MISS, pageNum, RS_LRU_K);
     Frames *frames = (Frames *) bm->mgmtData;
-    int k = bm->stratParam;
-    int orderNum[bm->numPages];
-    int LRU_PageIndex = 0;
-
-    // Populate the array with the order numbers of pages
-    for (int i = 0; i < bm->numPages; i++) {
-        orderNum[i] = frames[i].lruOrder;
-    }
 
-    // Sort the order numbers in ascending order using quicksort
-    quickSort(orderNum, 0, bm->numPages - 1);
-
-    // Find the page with the K-th least recent order number
-    for (int i = 0; i < bm->numPages; i++) {
-        if(orderNum[bm->numPages - k] == frames[i].lruOrder) {
-            LRU_PageIndex = i;
-            break;
-        }
+    // Find the page with the largest backward K-distance
+    int LRU_PageIndex = lruKVictim(bm);
+    if (LRU_PageIndex == -1) {
+        return RC_BP_PIN_ERROR;
     }
 
     // Check if the selected page is dirty and write it back to disk
     if (frames[LRU_PageIndex].dirty) {
         lockLatchForWrite(&(frames->pageLatches[LRU_PageIndex]));
-        SM_FileHandle fHandle;
-        openPageFile(bm->pageFile, &fHandle);
-        writeBlock(frames[LRU_PageIndex].pageNumber, &fHandle, frames[LRU_PageIndex].memPage);
-        closePageFile(&fHandle);
+        writeBlock(frames[LRU_PageIndex].pageNumber, &bm->fileHandle, frames[LRU_PageIndex].memPage);
         frames[LRU_PageIndex].dirty = false;
         writtenToDisk++;
+        bm->stats.writes++;
+        bm->stats.syncWritebacks++;
         releaseLatchAfterWrite(&(frames->pageLatches[LRU_PageIndex]));
     }
 
     // Read the new page from disk into the selected frame
     lockLatchForRead(&(frames->pageLatches[LRU_PageIndex]));
-    SM_FileHandle fHandle;
-    openPageFile(bm->pageFile, &fHandle);
-    ensureCapacity(pageNum, &fHandle);
-    readBlock(pageNum, &fHandle, frames[LRU_PageIndex].memPage);
-    closePageFile(&fHandle);
+    ensureCapacity(pageNum + 1, &bm->fileHandle);
+    readBlock(pageNum, &bm->fileHandle, frames[LRU_PageIndex].memPage);
     releaseLatchAfterRead(&(frames->pageLatches[LRU_PageIndex]));
 
     readFromDisk++;
+    bm->stats.reads++;
+    bm->stats.misses++;
+    bm->stats.evictions[RS_LRU_K]++;
+    notePinned(bm, frames[LRU_PageIndex].fix_cnt);
 
     // Update frame information with the new page and its usage order
     lruCounter++;
@@ -448,8 +1152,11 @@ RC LRU_K (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber p
     frames[LRU_PageIndex].dirty = false;
     frames[LRU_PageIndex].fix_cnt = 1;
     frames[LRU_PageIndex].lruOrder = lruCounter;
-    page->pageNum = pageNum;
-    page->data = frames[LRU_PageIndex].memPage;
+    frames[LRU_PageIndex].refCount = 1;
+    noteReference(&frames[LRU_PageIndex]);
+    frameStampCounter++;
+    frames[LRU_PageIndex].stamp = frameStampCounter;
+    setPageHandle(page, frames, LRU_PageIndex);
 
     return RC_OK;
 }
@@ -462,26 +1169,19 @@ RC LRU_K (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber p
  * @return     RC_OK on success, or an error code otherwise
  */
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page) {
-    printf("Marking dirty page.\n");
+    TRACE_DEBUG(TE_MARK_DIRTY, page->pageNum, 0);
     Frames *frames = (Frames *) bm->mgmtData;
-    int check_error = 0;
 
-    // Iterate through the frames to find the specified page
-    for (int i = 0; i< bm->numPages; i++) {
-        if (frames[i].pageNumber == page->pageNum) {
-            frames[i].dirty = true;
-        } else {
-            check_error++;
-        }
-    }
+    // Go to the frame holding the page
+    int frameIndex = findFrame(bm, page);
 
     // If the specified page is not found in any frame, return error
-    if(check_error == bm->numPages) {
+    if (frameIndex == -1) {
         return RC_BP_UNMARK_ERROR;
-    } else {
-        printf("Marked dirty page.\n");
-        return RC_OK;
     }
+
+    frames[frameIndex].dirty = true;
+    return RC_OK;
 }
 
 /*
@@ -492,26 +1192,29 @@ RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page) {
  * @return     RC_OK on success, or an error code otherwise
  */
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page) {
-    printf("Unpinning page.\n");
+    TRACE_DEBUG(TE_UNPIN, page->pageNum, 0);
     Frames *frames = (Frames *) bm->mgmtData;
 
-    // Iterate through the frames to find the specified page
-    for (int i = 0; i< bm->numPages; i++) {
-        if (frames[i].pageNumber == page->pageNum) {
-            if (frames[i].fix_cnt > 0) {
-                frames[i].fix_cnt--;
-                printf("Unpinned page.\n");
-                return RC_OK;
-            } else {
-                printf("Page is already unpinned.\n");
-                return RC_BP_UNPIN_ERROR;
-            }
-        }
-    }
+    // Go to the frame holding the page
+    int frameIndex = findFrame(bm, page);
 
     // If the specified page is not found in any frame, return error
-    printf("Page not found in buffer pool.\n");
-    return RC_BP_UNPIN_ERROR;
+    if (frameIndex == -1) {
+        TRACE_ERROR(TE_UNPIN_FAILED, page->pageNum, 0);
+        return RC_BP_UNPIN_ERROR;
+    }
+
+    if (frames[frameIndex].fix_cnt > 0) {
+        frames[frameIndex].fix_cnt--;
+        if (frames[frameIndex].fix_cnt == 0) {
+            bm->stats.pinnedFrames--;
+        }
+        tracePageRef(bm, &frames[frameIndex], BM_TRACE_UNPIN);
+        return RC_OK;
+    } else {
+        TRACE_ERROR(TE_UNPIN_FAILED, page->pageNum, 1);
+        return RC_BP_UNPIN_ERROR;
+    }
 }
 
 /*
@@ -522,33 +1225,26 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page) {
  * @return     RC_OK on success, or an error code otherwise
  */
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page) {
-    printf("Forcing dirty page to disk.\n");
+    TRACE_DEBUG(TE_FORCE_PAGE, page->pageNum, 0);
     Frames *frames = (Frames *) bm->mgmtData;
-    int numPages = bm->numPages;
-    int check_error = 0;
 
-    // Iterate through the frames to find the specified page
-    for (int i = 0; i< numPages; i++) {
-        if (frames[i].pageNumber == page->pageNum) {
-            lockLatchForWrite(&(frames->pageLatches[i]));
-            SM_FileHandle fHandle;
-            openPageFile(bm->pageFile, &fHandle);
-            writeBlock(frames[i].pageNumber, &fHandle, frames[i].memPage);
-            closePageFile(&fHandle);
-            frames[i].dirty = false;
-            writtenToDisk++;
-            releaseLatchAfterWrite(&(frames->pageLatches[i]));
-        } else {
-            check_error++;
-        }
-    }
+    // Go to the frame holding the page
+    int frameIndex = findFrame(bm, page);
 
     // If the specified page is not found in any frame, return error
-    if(check_error == bm->numPages) {
+    if (frameIndex == -1) {
         return RC_BP_FORCE_ERROR;
-    } else {
-        return RC_OK;
     }
+
+    lockLatchForWrite(&(frames->pageLatches[frameIndex]));
+    writeBlock(frames[frameIndex].pageNumber, &bm->fileHandle, frames[frameIndex].memPage);
+    frames[frameIndex].dirty = false;
+    writtenToDisk++;
+    bm->stats.writes++;
+    bm->stats.backgroundWritebacks++;
+    releaseLatchAfterWrite(&(frames->pageLatches[frameIndex]));
+
+    return RC_OK;
 }
 
 /*
@@ -562,25 +1258,51 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page) {
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
             const PageNumber pageNum) {
 
-    printf("Pinning page.\n");
     if (!isInitialized_bp) {
+        TRACE_ERROR(TE_PIN_FAILED, pageNum, 0);
         return RC_BP_PIN_ERROR;
     }
 
     Frames *frames = (Frames *) bm->mgmtData;
 
     if (pageNum < 0) {
+        bm->stats.pinFailures++;
         return RC_BP_PIN_ERROR;
     }
 
+    LATENCY_START(start);
+
+    // Re-pin through the same handle goes straight to the hinted frame
+    if (page->pageNum == pageNum && frameHintValid(bm, frames, page)) {
+        Frames *frame = &frames[page->frameIndex];
+        bm->stats.hits++;
+        notePinned(bm, frame->fix_cnt);
+        lruCounter++;
+        frame->fix_cnt++;
+        frame->lruOrder = lruCounter;
+        frame->refCount++;
+        noteReference(frame);
+        page->data = frame->memPage;
+        TRACE_DEBUG(TE_PIN_HIT, pageNum, page->frameIndex);
+        LATENCY_RECORD(LAT_PIN_HIT, start);
+        tracePageRef(bm, frame, BM_TRACE_PIN);
+        return RC_OK;
+    }
+
     // Check if page is already in buffer pool
     for (int i = 0; i< bm->numPages; i++) {
         if (frames[i].pageNumber == pageNum) {
+            bm->stats.hits++;
+            notePinned(bm, frames[i].fix_cnt);
             lruCounter++;
             frames[i].fix_cnt++;
             frames[i].lruOrder = lruCounter;
-            page->pageNum = pageNum;
-            page->data = frames[i].memPage;
+            frames[i].refCount++;
+            noteReference(&frames[i]);
+            setPageHandle(page, frames, i);
+            TRACE_DEBUG(TE_PIN_HIT, pageNum, i);
+            LATENCY_RECORD(LAT_PIN_HIT, start);
+            tracePageRef(bm, &frames[i], BM_TRACE_PIN);
             return RC_OK;
         }
     }
@@ -596,37 +1318,288 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
 
     // Free slot found
     if (freeSlotIndex != -1) {
+        TRACE_DEBUG(TE_PIN_MISS, pageNum, freeSlotIndex);
         lockLatchForRead(&(frames->pageLatches[freeSlotIndex]));
         // Read page from disk into the selected frame
-        SM_FileHandle fHandle;
-        openPageFile(bm->pageFile, &fHandle);
-        ensureCapacity(pageNum, &fHandle);
-        readBlock(pageNum, &fHandle, frames[freeSlotIndex].memPage);
-        closePageFile(&fHandle);
+        ensureCapacity(pageNum + 1, &bm->fileHandle);
+        readBlock(pageNum, &bm->fileHandle, frames[freeSlotIndex].memPage);
         releaseLatchAfterRead(&(frames->pageLatches[freeSlotIndex]));
 
         readFromDisk++;
+        bm->stats.reads++;
+        bm->stats.misses++;
+        notePinned(bm, 0);
 
         // Update frame details
+        lruCounter++;
         frames[freeSlotIndex].fix_cnt = 1;
+        frames[freeSlotIndex].lruOrder = lruCounter;
+        frames[freeSlotIndex].refCount = 1;
+        noteReference(&frames[freeSlotIndex]);
         frames[freeSlotIndex].pageNumber = pageNum;
-        page->pageNum = pageNum;
-        page->data = frames[freeSlotIndex].memPage;
+        frameStampCounter++;
+        frames[freeSlotIndex].stamp = frameStampCounter;
+        setPageHandle(page, frames, freeSlotIndex);
 
+        LATENCY_RECORD(LAT_PIN_MISS, start);
+        tracePageRef(bm, &frames[freeSlotIndex], BM_TRACE_PIN);
         return RC_OK;
     }
 
     // No free slot found, call the appropriate replacement strategy function
+    RC rc;
     switch (bm->strategy) {
         case RS_FIFO:
-            return FIFO(bm, page, pageNum);
+            rc = FIFO(bm, page, pageNum);
+            break;
         case RS_LRU:
-            return LRU(bm, page, pageNum);
+            rc = LRU(bm, page, pageNum);
+            break;
         case RS_LRU_K:
-            return LRU_K(bm, page, pageNum);
+            rc = LRU_K(bm, page, pageNum);
+            break;
         default:
+            rc = RC_BP_PIN_ERROR;
+            break;
+    }
+    if (rc != RC_OK) {
+        bm->stats.pinFailures++;
+    } else {
+        LATENCY_RECORD(LAT_PIN_MISS, start);
+        tracePageRef(bm, &frames[page->frameIndex], BM_TRACE_PIN);
+    }
+    return rc;
+}
+
+
+// A page missing from the pool during a batch pin, and the frame claimed for it
+typedef struct BatchMiss {
+    PageNumber pageNum;
+    int frameIndex;
+} BatchMiss;
+
+// Orders batch misses by page number so runs of pages can be read together
+static int compareBatchMissByPage(const void *a, const void *b) {
+    const BatchMiss *left = (const BatchMiss *) a;
+    const BatchMiss *right = (const BatchMiss *) b;
+    return left->pageNum - right->pageNum;
+}
+
+/*
+ * Chooses an unpinned frame to receive a page during a batch pin.
+ * Empty frames are used first. Otherwise FIFO pools scan in load order from the
+ * FIFO position, LRU-K pools take the frame LRU_K would evict, and every other
+ * strategy takes the least recently used frame.
+ *
+ * @return the frame index, or -1 if every frame is pinned
+ */
+static int selectVictimFrame(BM_BufferPool *const bm) {
+    Frames *frames = (Frames *) bm->mgmtData;
+
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames[i].pageNumber == NO_PAGE && frames[i].fix_cnt == 0) {
+            return i;
+        }
+    }
+
+    if (bm->strategy == RS_FIFO) {
+        int index = readFromDisk % bm->numPages;
+        for (int i = 0; i < bm->numPages; i++) {
+            if (frames[index].fix_cnt == 0) {
+                return index;
+            }
+            index = (index + 1) % bm->numPages;
+        }
+        return -1;
+    }
+
+    return bm->strategy == RS_LRU_K ? lruKVictim(bm) : lruVictim(bm);
+}
+
+/*
+ * Pins several pages in one call.
+ * Resident pages are pinned during a single lookup pass. Frames are then claimed
+ * for all missing pages at once, dirty victims are written back, and the missing
+ * pages are read in page order with one multi-page read per contiguous run.
+ * The call returns once every page is resident and pinned. If frames run out or
+ * a victim cannot be written back, every pin taken by the call is released and
+ * an error is returned.
+ *
+ * @param bm       Buffer pool containing information about the buffer pool
+ * @param handles  Array of n page handles to fill in
+ * @param pageNums Array of n page numbers to pin; duplicates are pinned twice
+ * @param n        Number of pages to pin
+ * @return         RC_OK on success, or RC_BP_PIN_ERROR otherwise
+ */
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const handles,
+             const PageNumber *const pageNums, const int n) {
+    if (!isInitialized_bp) {
+        return RC_BP_PIN_ERROR;
+    }
+    if (n <= 0) {
+        bm->stats.pinFailures++;
+        return RC_BP_PIN_ERROR;
+    }
+    for (int k = 0; k < n; k++) {
+        if (pageNums[k] < 0) {
+            bm->stats.pinFailures++;
             return RC_BP_PIN_ERROR;
+        }
     }
+
+    Frames *frames = (Frames *) bm->mgmtData;
+    BatchMiss *misses = malloc(sizeof(BatchMiss) * n);
+    int *pinnedFrames = malloc(sizeof(int) * n);
+    if (misses == NULL || pinnedFrames == NULL) {
+        free(misses);
+        free(pinnedFrames);
+        return RC_BP_PIN_ERROR;
+    }
+    int numMisses = 0;
+    int numPinned = 0;
+
+    RC rc = RC_OK;
+    for (int k = 0; k < n && rc == RC_OK; k++) {
+        // Resident pages, including ones claimed earlier in this batch, are plain hits
+        int frameIndex = -1;
+        for (int i = 0; i < bm->numPages; i++) {
+            if (frames[i].pageNumber == pageNums[k]) {
+                frameIndex = i;
+                break;
+            }
+        }
+
+        if (frameIndex != -1) {
+            TRACE_DEBUG(TE_PIN_HIT, pageNums[k], frameIndex);
+            bm->stats.hits++;
+            notePinned(bm, frames[frameIndex].fix_cnt);
+            lruCounter++;
+            frames[frameIndex].fix_cnt++;
+            frames[frameIndex].lruOrder = lruCounter;
+            frames[frameIndex].refCount++;
+            noteReference(&frames[frameIndex]);
+        } else {
+            frameIndex = selectVictimFrame(bm);
+            if (frameIndex == -1) {
+                TRACE_ERROR(TE_PIN_FAILED, pageNums[k], 0);
+                rc = RC_BP_PIN_ERROR;
+                break;
+            }
+            // Write the victim back before handing its frame to the new page; if the
+            // write fails the victim stays resident and dirty and the batch is undone
+            Frames *victim = &frames[frameIndex];
+            if (victim->pageNumber != NO_PAGE && victim->dirty) {
+                lockLatchForWrite(&(frames->pageLatches[frameIndex]));
+                rc = writeBlock(victim->pageNumber, &bm->fileHandle, victim->memPage);
+                releaseLatchAfterWrite(&(frames->pageLatches[frameIndex]));
+                if (rc != RC_OK) {
+                    TRACE_ERROR(TE_PIN_FAILED, pageNums[k], frameIndex);
+                    rc = RC_BP_PIN_ERROR;
+                    break;
+                }
+                writtenToDisk++;
+                bm->stats.writes++;
+                bm->stats.syncWritebacks++;
+            }
+            TRACE_DEBUG(TE_PIN_MISS, pageNums[k], frameIndex);
+            bm->stats.misses++;
+            notePinned(bm, 0);
+            if (victim->pageNumber != NO_PAGE) {
+                // selectVictimFrame decides in FIFO, LRU-K or else LRU order
+                bm->stats.evictions[bm->strategy == RS_FIFO || bm->strategy == RS_LRU_K ? bm->strategy : RS_LRU]++;
+            }
+
+            // Claim the frame now, the read is issued with the rest of the batch
+            lruCounter++;
+            frameStampCounter++;
+            victim->pageNumber = pageNums[k];
+            victim->dirty = false;
+            victim->fix_cnt = 1;
+            victim->lruOrder = lruCounter;
+            victim->refCount = 1;
+            noteReference(victim);
+            victim->stamp = frameStampCounter;
+            misses[numMisses].pageNum = pageNums[k];
+            misses[numMisses].frameIndex = frameIndex;
+            numMisses++;
+        }
+        pinnedFrames[numPinned++] = frameIndex;
+        setPageHandle(&handles[k], frames, frameIndex);
+    }
+
+    if (rc == RC_OK && numMisses > 0) {
+        qsort(misses, numMisses, sizeof(BatchMiss), compareBatchMissByPage);
+        ensureCapacity(misses[numMisses - 1].pageNum + 1, &bm->fileHandle);
+
+        SM_PageHandle memPages[numMisses];
+        int runStart = 0;
+        while (runStart < numMisses && rc == RC_OK) {
+            int runEnd = runStart + 1;
+            while (runEnd < numMisses && misses[runEnd].pageNum == misses[runEnd - 1].pageNum + 1) {
+                runEnd++;
+            }
+            for (int i = runStart; i < runEnd; i++) {
+                memPages[i - runStart] = frames[misses[i].frameIndex].memPage;
+            }
+            rc = readBlocks(misses[runStart].pageNum, runEnd - runStart, &bm->fileHandle, memPages);
+            if (rc == RC_OK) {
+                readFromDisk += runEnd - runStart;
+                bm->stats.reads += runEnd - runStart;
+            }
+            runStart = runEnd;
+        }
+        if (rc != RC_OK) {
+            rc = RC_BP_PIN_ERROR;
+        }
+    }
+    // On failure release everything this call pinned and forget unread claims
+    if (rc != RC_OK) {
+        for (int i = 0; i < numPinned; i++) {
+            frames[pinnedFrames[i]].fix_cnt--;
+            if (frames[pinnedFrames[i]].fix_cnt == 0) {
+                bm->stats.pinnedFrames--;
+            }
+        }
+        for (int i = 0; i < numMisses; i++) {
+            Frames *claimed = &frames[misses[i].frameIndex];
+            if (claimed->fix_cnt == 0) {
+                claimed->pageNumber = NO_PAGE;
+                claimed->stamp = 0;
+            }
+        }
+    }
+
+    if (rc != RC_OK) {
+        bm->stats.pinFailures++;
+    } else {
+        for (int i = 0; i < numPinned; i++) {
+            tracePageRef(bm, &frames[pinnedFrames[i]], BM_TRACE_PIN);
+        }
+    }
+
+    free(misses);
+    free(pinnedFrames);
+    return rc;
+}
+
+/*
+ * Unpins several pages in one call. Every handle is unpinned even if an earlier
+ * one fails.
+ *
+ * @param bm      Buffer pool containing information about the buffer pool
+ * @param handles Array of n page handles previously filled by pinPage or pinPages
+ * @param n       Number of pages to unpin
+ * @return        RC_OK on success, or the first error encountered
+ */
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const handles, const int n) {
+    RC result = RC_OK;
+    for (int k = 0; k < n; k++) {
+        RC rc = unpinPage(bm, &handles[k]);
+        if (rc != RC_OK && result == RC_OK) {
+            result = rc;
+        }
+    }
+    return result;
 }
 
 
@@ -700,7 +1673,7 @@ bool *getDirtyFlags (BM_BufferPool *const bm) {
 int *getFixCounts (BM_BufferPool *const bm) {
     Frames *frames = (Frames *)bm->mgmtData;
     int numPages = bm->numPages;
-    int *fixCounts = malloc(sizeof(bool) * numPages);
+    int *fixCounts = malloc(sizeof(int) * numPages);
 
     // Iterate over all page frames
     for (int i = 0; i < numPages; i++) {
@@ -716,21 +1689,54 @@ int *getFixCounts (BM_BufferPool *const bm) {
 }
 
 /*
- * Retrieves the total number of read operations performed on the buffer pool.
+ * Retrieves the number of pages this buffer pool has read from disk.
  *
  * @param bm Buffer pool containing information about the buffer pool
- * @return   The total number of read operations performed on the buffer pool
+ * @return   The number of pages read since the pool was initialized or its stats reset
  */
 int getNumReadIO (BM_BufferPool *const bm) {
-    return (readFromDisk + 1);
+    return (int) bm->stats.reads;
 }
 
 /*
- * Retrieves the total number of write operations performed on the buffer pool.
+ * Retrieves the number of pages this buffer pool has written to disk.
  *
  * @param bm Buffer pool containing information about the buffer pool
- * @return   The total number of write operations performed on the buffer pool
+ * @return   The number of pages written since the pool was initialized or its stats reset
  */
 int getNumWriteIO (BM_BufferPool *const bm) {
-    return writtenToDisk;
+    return (int) bm->stats.writes;
+}
+
+/*
+ * Copies the statistics of a buffer pool.
+ *
+ * @param bm    Buffer pool containing information about the buffer pool
+ * @param stats Receives a snapshot of the pool's counters
+ * @return      RC_OK on success, or RC_BP_INIT_ERROR if the pool is not initialized
+ */
+RC getBufferPoolStats (BM_BufferPool *const bm, BM_Stats *const stats) {
+    if (bm->mgmtData == NULL) {
+        return RC_BP_INIT_ERROR;
+    }
+    *stats = bm->stats;
+    return RC_OK;
+}
+
+/*
+ * Resets the statistics of a buffer pool, e.g. after a warm-up phase.
+ * The number of currently pinned frames is kept and becomes the new peak.
+ *
+ * @param bm Buffer pool containing information about the buffer pool
+ * @return   RC_OK on success, or RC_BP_INIT_ERROR if the pool is not initialized
+ */
+RC resetBufferPoolStats (BM_BufferPool *const bm) {
+    if (bm->mgmtData == NULL) {
+        return RC_BP_INIT_ERROR;
+    }
+    int pinnedFrames = bm->stats.pinnedFrames;
+    memset(&bm->stats, 0, sizeof(BM_Stats));
+    bm->stats.pinnedFrames = pinnedFrames;
+    bm->stats.peakPinnedFrames = pinnedFrames;
+    return RC_OK;
 }
\ No newline at end of file
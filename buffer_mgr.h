@@ -12,6 +12,8 @@
 
 #include <time.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
 
 extern pthread_mutex_t buffer_pool_init_mutex;
 extern pthread_cond_t buffer_pool_cond;
@@ -27,6 +29,12 @@ typedef enum ReplacementStrategy {
 	RS_LRU_K = 4
 } ReplacementStrategy;
 
+#define RS_NUM_STRATEGIES 5
+
+// History depth of RS_LRU_K: stratParam is clamped to it and defaults to BM_LRU_K_DEFAULT
+#define BM_LRU_K_MAX 8
+#define BM_LRU_K_DEFAULT 2
+
 // Data Types and Structures
 typedef int PageNumber;
 #define NO_PAGE -1
@@ -37,14 +45,59 @@ typedef struct Frames {
     bool dirty;
     int fix_cnt;
     int lruOrder;
+    int refCount;     // number of pins since the page was loaded
+    int history[BM_LRU_K_MAX]; // lruOrder of the last pins, most recent first; the first refCount are the page's
+    unsigned int stamp; // changes whenever the frame is given a new page
     Latch *pageLatches;
 } Frames;
 
+// Per-pool counters, kept since initBufferPool or the last resetBufferPoolStats
+typedef struct BM_Stats {
+    long hits;                            // pins served from a resident frame
+    long misses;                          // pins that had to read the page
+    long evictions[RS_NUM_STRATEGIES];    // resident pages replaced, by the strategy that chose them
+    long resizeEvictions;                 // resident pages dropped by resizeBufferPool
+    long syncWritebacks;                  // dirty victims written while a pin waited
+    long backgroundWritebacks;            // dirty pages written by flush, force, resize or shutdown
+    long pinFailures;                     // pin requests that returned an error
+    long reads;                           // pages read from disk
+    long writes;                          // pages written to disk
+    int pinnedFrames;                     // frames currently pinned
+    int peakPinnedFrames;                 // highest pinnedFrames seen
+} BM_Stats;
+
+// Page reference trace: a BM_TraceHeader followed by one BM_TraceEvent per
+// pin or unpin, replayed offline by policy_sim
+#define BM_TRACE_MAGIC 0x52544D42
+#define BM_TRACE_VERSION 1
+
+typedef enum BM_TraceEventKind {
+    BM_TRACE_PIN = 0,
+    BM_TRACE_UNPIN = 1
+} BM_TraceEventKind;
+
+typedef struct BM_TraceHeader {
+    uint32_t magic;
+    uint32_t version;
+} BM_TraceHeader;
+
+typedef struct BM_TraceEvent {
+    uint64_t timestamp;   // CLOCK_MONOTONIC nanoseconds
+    int32_t pageNum;
+    uint8_t kind;         // BM_TraceEventKind
+    uint8_t dirty;        // frame was dirty after the event
+    uint16_t reserved;
+} BM_TraceEvent;
+
 typedef struct BM_BufferPool {
 	char *pageFile;
 	int numPages;
 	ReplacementStrategy strategy;
     int stratParam;
+    bool persistResidency; // write a residency snapshot on shutdown
+    BM_Stats stats;
+    FILE *pageTrace;       // page reference trace, or NULL
+    SM_FileHandle fileHandle; // page file, open while the pool is initialized
 	void *mgmtData; // use this one to store the bookkeeping info your buffer
 	// manager needs for a buffer pool
 } BM_BufferPool;
@@ -52,6 +105,8 @@ typedef struct BM_BufferPool {
 typedef struct BM_PageHandle {
 	PageNumber pageNum;
 	char *data;
+	int frameIndex;           // frame the page was pinned in (hint)
+	unsigned int frameStamp;  // stamp of that frame when pinned
 } BM_PageHandle;
 
 
@@ -68,6 +123,16 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 		void *stratData);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
+RC truncatePool(BM_BufferPool *const bm, const int numPages);
+
+// Warm Restart
+RC enableResidencySnapshot(BM_BufferPool *const bm, bool enable);
+RC discardResidencySnapshot(const char *const pageFileName);
+
+// Page Reference Tracing
+RC enablePageTrace(BM_BufferPool *const bm, const char *const traceFileName);
+RC disablePageTrace(BM_BufferPool *const bm);
 
 // Replacement Strategies Functions
 RC FIFO (BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum);
@@ -80,6 +145,9 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const handles,
+		const PageNumber *const pageNums, const int n);
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const handles, const int n);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -87,6 +155,8 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+RC getBufferPoolStats (BM_BufferPool *const bm, BM_Stats *const stats);
+RC resetBufferPoolStats (BM_BufferPool *const bm);
 
 
 #endif
@@ -7,6 +7,8 @@
 // local functions
 static void printStrat (BM_BufferPool *const bm);
 
+static const char *strategyNames[RS_NUM_STRATEGIES] = { "FIFO", "LRU", "CLOCK", "LFU", "LRU-K" };
+
 // external functions
 void 
 printPoolContent (BM_BufferPool *const bm)
@@ -54,6 +56,54 @@ sprintPoolContent (BM_BufferPool *const bm)
 	return message;
 }
 
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+	char *message = sprintPoolStats(bm);
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: %s", bm->numPages, message);
+	free(message);
+}
+
+char *
+sprintPoolStats (BM_BufferPool *const bm)
+{
+	BM_Stats stats;
+	char *message;
+	int pos = 0;
+	int i;
+
+	message = (char *) malloc(768 + 32 * RS_NUM_STRATEGIES);
+	if (getBufferPoolStats(bm, &stats) != RC_OK)
+	{
+		sprintf(message, "no statistics, pool not initialized\n");
+		return message;
+	}
+
+	long pins = stats.hits + stats.misses;
+	pos += sprintf(message + pos, "hits %ld, misses %ld, hit ratio %.3f\n",
+			stats.hits, stats.misses, pins == 0 ? 0.0 : (double) stats.hits / pins);
+	pos += sprintf(message + pos, "evictions:");
+	for (i = 0; i < RS_NUM_STRATEGIES; i++)
+		if (stats.evictions[i] > 0)
+			pos += sprintf(message + pos, " %s %ld", strategyNames[i], stats.evictions[i]);
+	pos += sprintf(message + pos, " resize %ld\n", stats.resizeEvictions);
+	pos += sprintf(message + pos, "writebacks: sync %ld, background %ld\n",
+			stats.syncWritebacks, stats.backgroundWritebacks);
+	pos += sprintf(message + pos, "reads %ld, writes %ld, pin failures %ld\n",
+			stats.reads, stats.writes, stats.pinFailures);
+	pos += sprintf(message + pos, "pinned frames %i, peak %i\n",
+			stats.pinnedFrames, stats.peakPinnedFrames);
+
+	SM_FileIOStats io;
+	if (getFileIOStats(&bm->fileHandle, &io) == RC_OK)
+		pos += sprintf(message + pos, "file io: %ld pages read in %ld calls, %ld pages written in %ld calls, %ld extensions, %.3f ms blocked\n",
+				io.pagesRead, io.readCalls, io.pagesWritten, io.writeCalls, io.extensions, io.ioNanos / 1e6);
+
+	return message;
+}
 
 void
 printPageContent (BM_PageHandle *const page)
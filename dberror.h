@@ -53,6 +53,8 @@ typedef int RC;
 #define RC_BP_UNPIN_ERROR 405
 #define RC_BP_UNMARK_ERROR 406
 #define RC_BP_FORCE_ERROR 407
+#define RC_BP_RESIZE_ERROR 408
+#define RC_BP_TRUNCATE_ERROR 409
 
 #define RC_RM_TABLE_ERROR 501
 #define RC_RM_NO_SLOT_ERROR 502
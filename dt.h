@@ -4,6 +4,16 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+
+#include "trace.h"
+
+// Latch contention profiling, enable with "make LATCH_PROFILING=1"
+#ifndef LATCH_PROFILING
+#define LATCH_PROFILING 0
+#endif
 
 // define bool if not defined
 #ifndef bool
@@ -15,22 +25,75 @@
 #define TRUE true
 #define FALSE false
 
+#define LATCH_NAME_LENGTH 48
+
+// Contention counters of one named latch
+typedef struct LatchStats {
+    char name[LATCH_NAME_LENGTH];
+    uint64_t acquisitions;   // read and write acquisitions
+    uint64_t contended;      // acquisitions that had to wait
+    uint64_t waitNanos;      // total time spent waiting
+    uint64_t maxWaitNanos;   // longest single wait
+} LatchStats;
+
+// Shared by every latch with the same name, so counters survive the latch
+typedef struct LatchProfile LatchProfile;
+
 // typedef Structure to represent a latch
 typedef struct {
     pthread_rwlock_t lock;   // Read-write lock
+#if LATCH_PROFILING
+    LatchProfile *profile;   // counters, "unnamed" until nameLatch is called
+#endif
 } Latch;
 
+// Latch registry, see latch.c; no-ops unless LATCH_PROFILING is set
+extern void registerLatch(Latch *latch);
+extern void nameLatch(Latch *latch, const char *format, ...);
+extern void recordLatchWait(Latch *latch, uint64_t waitNanos);
+extern RC getLatchStats(const char *name, LatchStats *stats);
+extern void resetLatchStats(void);
+extern void printLatchReport(FILE *out);
+
 // Function declarations and definitions
 
 // Create and Destroy Latch Function
 static inline void createLatch(Latch *latch) {
     pthread_rwlock_init(&latch->lock, NULL);
+#if LATCH_PROFILING
+    registerLatch(latch);
+#endif
 }
 
 static inline void destroyLatch(Latch *latch) {
     pthread_rwlock_destroy(&latch->lock);
 }
 
+// Takes the lock, counting the acquisition and timing it if it has to wait
+static inline int acquireLatch(Latch *latch, bool write) {
+#if LATCH_PROFILING
+    int result = write ? pthread_rwlock_trywrlock(&latch->lock) : pthread_rwlock_tryrdlock(&latch->lock);
+    if (result != EBUSY) {
+        if (result == 0) {
+            recordLatchWait(latch, 0);
+        }
+        return result;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = write ? pthread_rwlock_wrlock(&latch->lock) : pthread_rwlock_rdlock(&latch->lock);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (result == 0) {
+        recordLatchWait(latch, (uint64_t) (end.tv_sec - start.tv_sec) * 1000000000ULL
+                               + (uint64_t) end.tv_nsec - (uint64_t) start.tv_nsec);
+    }
+    return result;
+#else
+    return write ? pthread_rwlock_wrlock(&latch->lock) : pthread_rwlock_rdlock(&latch->lock);
+#endif
+}
+
 // Acquiring
 
 // Acquire the latch for reading
@@ -39,9 +102,10 @@ static inline void lockLatchForRead(Latch *latch) {
         fprintf(stderr, "Error: Null latch pointer at location %p\n", (void *)latch);
         return;
     }
-    printf("Locking latch for read operation at location %p\n", (void *)latch);
-    int result = pthread_rwlock_rdlock(&latch->lock);
+    TRACE_DEBUG(TE_LATCH_READ_ACQUIRE, (uintptr_t)latch, 0);
+    int result = acquireLatch(latch, false);
     if (result != 0) {
+        TRACE_ERROR(TE_LATCH_ERROR, (uintptr_t)latch, result);
         fprintf(stderr, "Failed to acquire read lock: error code %d\n", result);
     }
 }
@@ -52,9 +116,10 @@ static inline void lockLatchForWrite(Latch *latch) {
         fprintf(stderr, "Error: Null latch pointer at location %p\n", (void *)latch);
         return;
     }
-    printf("Locking latch for write operation at location %p\n", (void *)latch);
-    int result = pthread_rwlock_wrlock(&latch->lock);
+    TRACE_DEBUG(TE_LATCH_WRITE_ACQUIRE, (uintptr_t)latch, 0);
+    int result = acquireLatch(latch, true);
     if (result != 0) {
+        TRACE_ERROR(TE_LATCH_ERROR, (uintptr_t)latch, result);
         fprintf(stderr, "Failed to acquire write lock: error code %d\n", result);
     }
 }
@@ -63,21 +128,21 @@ static inline void lockLatchForWrite(Latch *latch) {
 
 // Releasing latch after reading
 static inline void releaseLatchAfterRead(Latch *latch) {
-    printf("Releasing latch after reading at location %p\n", (void *)latch);
+    TRACE_DEBUG(TE_LATCH_READ_RELEASE, (uintptr_t)latch, 0);
     int unlockResult = pthread_rwlock_unlock(&latch->lock);
     if (unlockResult != 0) {
-        printf("Failed to release latch\n");
-        printf("Error code: %d\n", unlockResult);
+        TRACE_ERROR(TE_LATCH_ERROR, (uintptr_t)latch, unlockResult);
+        fprintf(stderr, "Failed to release latch: error code %d\n", unlockResult);
     }
 }
 
 // Releasing latch after writing
 static inline void releaseLatchAfterWrite(Latch *latch) {
-    printf("Releasing latch after writing at location %p\n", (void *)latch);
+    TRACE_DEBUG(TE_LATCH_WRITE_RELEASE, (uintptr_t)latch, 0);
     int unlockResult = pthread_rwlock_unlock(&latch->lock);
     if (unlockResult != 0) {
-        printf("Failed to release latch\n");
-        printf("Error code: %d\n", unlockResult);
+        TRACE_ERROR(TE_LATCH_ERROR, (uintptr_t)latch, unlockResult);
+        fprintf(stderr, "Failed to release latch: error code %d\n", unlockResult);
     }
 }
 
@@ -7,9 +7,22 @@
 #include "tables.h"
 
 // implementations
+// A comparison with NULL is never true
+static bool
+nullComparison (Value *left, Value *right, Value *result)
+{
+	if (left->dt != DT_NULL && right->dt != DT_NULL)
+		return false;
+	result->dt = DT_BOOL;
+	result->v.boolV = FALSE;
+	return true;
+}
+
 RC 
 valueEquals (Value *left, Value *right, Value *result)
 {
+	if (nullComparison(left, right, result))
+		return RC_OK;
 	if(left->dt != right->dt)
 		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "equality comparison only supported for values of the same datatype");
 
@@ -26,8 +39,12 @@ valueEquals (Value *left, Value *right, Value *result)
 		result->v.boolV = (left->v.boolV == right->v.boolV);
 		break;
 	case DT_STRING:
+	case DT_VARCHAR:
 		result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) == 0);
 		break;
+	case DT_NULL:
+		// nullComparison has answered already
+		break;
 	}
 
 	return RC_OK;
@@ -36,6 +53,8 @@ valueEquals (Value *left, Value *right, Value *result)
 RC 
 valueSmaller (Value *left, Value *right, Value *result)
 {
+	if (nullComparison(left, right, result))
+		return RC_OK;
 	if(left->dt != right->dt)
 		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "equality comparison only supported for values of the same datatype");
 
@@ -51,8 +70,12 @@ valueSmaller (Value *left, Value *right, Value *result)
 	case DT_BOOL:
 		result->v.boolV = (left->v.boolV < right->v.boolV);
 	case DT_STRING:
+	case DT_VARCHAR:
 		result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
 		break;
+	case DT_NULL:
+		// nullComparison has answered already
+		break;
 	}
 
 	return RC_OK;
@@ -101,7 +124,15 @@ evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
 	case EXPR_OP:
 	{
 		Operator *op = expr->expr.op;
-		bool twoArgs = (op->type != OP_BOOL_NOT);
+		bool twoArgs = (op->type != OP_BOOL_NOT && op->type != OP_IS_NULL);
+
+		// An attribute is tested in the null bitmap, without reading its value
+		if (op->type == OP_IS_NULL && op->args[0]->type == EXPR_ATTRREF)
+		{
+			(*result)->dt = DT_BOOL;
+			(*result)->v.boolV = isAttrNull(record, schema, op->args[0]->expr.attrRef);
+			break;
+		}
 		//      lIn = (Value *) malloc(sizeof(Value));
 		//    rIn = (Value *) malloc(sizeof(Value));
 
@@ -126,6 +157,10 @@ evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
 		case OP_COMP_SMALLER:
 			CHECK(valueSmaller(lIn, rIn, *result));
 			break;
+		case OP_IS_NULL:
+			(*result)->dt = DT_BOOL;
+			(*result)->v.boolV = (lIn->dt == DT_NULL);
+			break;
 		default:
 			break;
 		}
@@ -157,6 +192,7 @@ RC freeExpr(Expr *expr) {
             Operator *op = expr->expr.op;
             switch (op->type) {
                 case OP_BOOL_NOT:
+                case OP_IS_NULL:
                     freeExpr(op->args[0]);
                     break;
                 default:
@@ -187,7 +223,7 @@ freeVal (Value *val)
     if (val == NULL)
         return;
 
-	if (val->dt == DT_STRING)
+	if (val->dt == DT_STRING || val->dt == DT_VARCHAR)
 		free(val->v.stringV);
 	free(val);
 }
@@ -26,7 +26,8 @@ typedef enum OpType {
   OP_BOOL_OR,
   OP_BOOL_NOT,
   OP_COMP_EQUAL,
-  OP_COMP_SMALLER
+  OP_COMP_SMALLER,
+  OP_IS_NULL
 } OpType;
 
 typedef struct Operator {
@@ -54,6 +55,7 @@ extern void freeVal(Value *val);
       (_result)->v.intV = _input->v.intV;					\
       break;								\
     case DT_STRING:							\
+    case DT_VARCHAR:							\
       (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV) + 1);	\
       strcpy((_result)->v.stringV, _input->v.stringV);			\
       break;								\
@@ -63,6 +65,8 @@ extern void freeVal(Value *val);
     case DT_BOOL:							\
       (_result)->v.boolV = _input->v.boolV;				\
       break;								\
+    case DT_NULL:							\
+      break;								\
     }									\
 } while(0)
 
@@ -0,0 +1,167 @@
+#include "fsm.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Class of a page with the given free space; a full page has class 0
+static inline int
+classOf (int freeSpace)
+{
+	if (freeSpace <= 0)
+		return 0;
+	int c = freeSpace / FSM_CLASS_BYTES;
+	return c < FSM_NUM_CLASSES ? c : FSM_NUM_CLASSES - 1;
+}
+
+static void
+unlinkPage (FreeSpaceMap *fsm, int page)
+{
+	int c = fsm->pageClass[page];
+
+	if (fsm->prev[page] != FSM_NO_PAGE)
+		fsm->next[fsm->prev[page]] = fsm->next[page];
+	else
+		fsm->heads[c] = fsm->next[page];
+	if (fsm->next[page] != FSM_NO_PAGE)
+		fsm->prev[fsm->next[page]] = fsm->prev[page];
+	if (fsm->heads[c] == FSM_NO_PAGE)
+		fsm->nonEmpty[c / 64] &= ~(1ULL << (c % 64));
+	fsm->totalFree -= (long) c * FSM_CLASS_BYTES;
+}
+
+static void
+linkPage (FreeSpaceMap *fsm, int page, int c)
+{
+	fsm->pageClass[page] = (uint16_t) c;
+	fsm->prev[page] = FSM_NO_PAGE;
+	fsm->next[page] = fsm->heads[c];
+	if (fsm->heads[c] != FSM_NO_PAGE)
+		fsm->prev[fsm->heads[c]] = page;
+	fsm->heads[c] = page;
+	fsm->nonEmpty[c / 64] |= 1ULL << (c % 64);
+	fsm->totalFree += (long) c * FSM_CLASS_BYTES;
+}
+
+// Makes room for pages [0, numPages), doubling the arrays
+static RC
+growTo (FreeSpaceMap *fsm, int numPages)
+{
+	if (numPages <= fsm->capacity)
+		return RC_OK;
+
+	int capacity = fsm->capacity == 0 ? 16 : fsm->capacity;
+	while (capacity < numPages)
+		capacity *= 2;
+
+	uint16_t *pageClass = (uint16_t *) realloc(fsm->pageClass, capacity * sizeof(uint16_t));
+	if (pageClass == NULL)
+		return RC_MEMORY_ALLOCATION_FAIL;
+	fsm->pageClass = pageClass;
+	int *next = (int *) realloc(fsm->next, capacity * sizeof(int));
+	if (next == NULL)
+		return RC_MEMORY_ALLOCATION_FAIL;
+	fsm->next = next;
+	int *prev = (int *) realloc(fsm->prev, capacity * sizeof(int));
+	if (prev == NULL)
+		return RC_MEMORY_ALLOCATION_FAIL;
+	fsm->prev = prev;
+
+	fsm->capacity = capacity;
+	return RC_OK;
+}
+
+// Creates an empty map
+void
+fsmInit (FreeSpaceMap *fsm)
+{
+	memset(fsm, 0, sizeof(FreeSpaceMap));
+	for (int c = 0; c < FSM_NUM_CLASSES; c++)
+		fsm->heads[c] = FSM_NO_PAGE;
+}
+
+void
+fsmFree (FreeSpaceMap *fsm)
+{
+	free(fsm->pageClass);
+	free(fsm->next);
+	free(fsm->prev);
+	fsmInit(fsm);
+}
+
+/*
+ * Records the free space of a data page, moving it to its new class. A page
+ * one past the last tracked page is appended.
+ *
+ * Returns:
+ * - RC_OK on success, RC_INVALID_INPUT for a page that is neither tracked
+ *   nor the next one, RC_MEMORY_ALLOCATION_FAIL if the map cannot grow.
+ */
+RC
+fsmSetFreeSpace (FreeSpaceMap *fsm, int page, int freeSpace)
+{
+	int c = classOf(freeSpace);
+
+	if (page < 0 || page > fsm->numPages)
+		return RC_INVALID_INPUT;
+
+	if (page == fsm->numPages)
+	{
+		RC rc = growTo(fsm, page + 1);
+		if (rc != RC_OK)
+			return rc;
+		fsm->numPages++;
+		linkPage(fsm, page, c);
+		return RC_OK;
+	}
+
+	if (fsm->pageClass[page] != c)
+	{
+		unlinkPage(fsm, page);
+		linkPage(fsm, page, c);
+	}
+	return RC_OK;
+}
+
+// Free space recorded for a tracked page, 0 for any other
+int
+fsmGetFreeSpace (const FreeSpaceMap *fsm, int page)
+{
+	if (page < 0 || page >= fsm->numPages)
+		return 0;
+	return fsm->pageClass[page] * FSM_CLASS_BYTES;
+}
+
+/*
+ * Finds a page with at least the given number of free bytes, taking it from
+ * the lowest class that has one so emptier pages stay available for larger
+ * requests. Within a class, the page whose free space changed last is taken
+ * first.
+ *
+ * Returns the page, or FSM_NO_PAGE if no tracked page has room.
+ */
+int
+fsmFindPage (const FreeSpaceMap *fsm, int needed)
+{
+	// Smallest class whose every page is guaranteed to have room
+	int c = needed <= 0 ? 1 : (needed + FSM_CLASS_BYTES - 1) / FSM_CLASS_BYTES;
+	if (c >= FSM_NUM_CLASSES)
+		return FSM_NO_PAGE;
+
+	uint64_t candidates = fsm->nonEmpty[c / 64] >> (c % 64);
+	if (candidates != 0)
+		return fsm->heads[c + __builtin_ctzll(candidates)];
+	for (int word = c / 64 + 1; word < FSM_MASK_WORDS; word++)
+		if (fsm->nonEmpty[word] != 0)
+			return fsm->heads[word * 64 + __builtin_ctzll(fsm->nonEmpty[word])];
+	return FSM_NO_PAGE;
+}
+
+// Stops tracking the pages at and after numPages
+void
+fsmTruncate (FreeSpaceMap *fsm, int numPages)
+{
+	for (int page = numPages; page < fsm->numPages; page++)
+		unlinkPage(fsm, page);
+	if (numPages < fsm->numPages)
+		fsm->numPages = numPages;
+}
@@ -0,0 +1,41 @@
+#ifndef FSM_H
+#define FSM_H
+
+#include <stdint.h>
+
+#include "dberror.h"
+
+/************************************************************
+ *                    free-space map                        *
+ ************************************************************/
+// Data pages of a table bucketed by free space. Pages are small, so there is
+// one class per number of free bytes: class c holds the pages with exactly c
+// free bytes. Every page of a class at or above the size of a record has room
+// for it, and finding one is a scan of the FSM_MASK_WORDS words of nonEmpty.
+#define FSM_CLASS_BYTES 1
+#define FSM_NUM_CLASSES (PAGE_SIZE / FSM_CLASS_BYTES + 1)
+#define FSM_MASK_WORDS ((FSM_NUM_CLASSES + 63) / 64)
+#define FSM_NO_PAGE -1
+
+typedef struct FreeSpaceMap {
+	int numPages;                 // data pages tracked, indexed like the page directory
+	int capacity;
+	uint16_t *pageClass;          // class of every page
+	int *next;                    // doubly linked list of the pages of one class
+	int *prev;
+	int heads[FSM_NUM_CLASSES];
+	uint64_t nonEmpty[FSM_MASK_WORDS]; // bit c % 64 of word c / 64 is set while class c has a page
+	long totalFree;               // free bytes of all tracked pages together
+} FreeSpaceMap;
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+extern void fsmInit (FreeSpaceMap *fsm);
+extern void fsmFree (FreeSpaceMap *fsm);
+extern RC fsmSetFreeSpace (FreeSpaceMap *fsm, int page, int freeSpace);
+extern int fsmGetFreeSpace (const FreeSpaceMap *fsm, int page);
+extern int fsmFindPage (const FreeSpaceMap *fsm, int needed);
+extern void fsmTruncate (FreeSpaceMap *fsm, int numPages);
+
+#endif // FSM_H
@@ -0,0 +1,209 @@
+#include "dt.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#if LATCH_PROFILING
+
+// Counters of every latch carrying the same name
+struct LatchProfile {
+    char name[LATCH_NAME_LENGTH];
+    _Atomic uint64_t acquisitions;
+    _Atomic uint64_t contended;
+    _Atomic uint64_t waitNanos;
+    _Atomic uint64_t maxWaitNanos;
+    LatchProfile *next;
+};
+
+// Registry of profiles by name; profiles are never freed so that latches of a
+// destroyed pool keep their history and a rebuilt pool continues it
+static pthread_mutex_t latchRegistryMutex = PTHREAD_MUTEX_INITIALIZER;
+static LatchProfile *latchProfiles = NULL;
+
+// Finds the profile of a name, creating it on first use
+static LatchProfile *profileFor(const char *name) {
+    pthread_mutex_lock(&latchRegistryMutex);
+    LatchProfile *profile = latchProfiles;
+    while (profile != NULL && strcmp(profile->name, name) != 0) {
+        profile = profile->next;
+    }
+    if (profile == NULL) {
+        profile = calloc(1, sizeof(LatchProfile));
+        if (profile != NULL) {
+            snprintf(profile->name, LATCH_NAME_LENGTH, "%s", name);
+            profile->next = latchProfiles;
+            latchProfiles = profile;
+        }
+    }
+    pthread_mutex_unlock(&latchRegistryMutex);
+    return profile;
+}
+
+// Orders latch stats from most to least total wait time
+static int compareLatchStatsByWait(const void *a, const void *b) {
+    const LatchStats *left = (const LatchStats *) a;
+    const LatchStats *right = (const LatchStats *) b;
+    if (left->waitNanos != right->waitNanos) {
+        return left->waitNanos < right->waitNanos ? 1 : -1;
+    }
+    return strcmp(left->name, right->name);
+}
+
+// Copies a profile's counters; updates racing with the copy may be partly included
+static void copyLatchStats(LatchProfile *profile, LatchStats *stats) {
+    memcpy(stats->name, profile->name, LATCH_NAME_LENGTH);
+    stats->acquisitions = atomic_load_explicit(&profile->acquisitions, memory_order_relaxed);
+    stats->contended = atomic_load_explicit(&profile->contended, memory_order_relaxed);
+    stats->waitNanos = atomic_load_explicit(&profile->waitNanos, memory_order_relaxed);
+    stats->maxWaitNanos = atomic_load_explicit(&profile->maxWaitNanos, memory_order_relaxed);
+}
+
+#endif
+
+/*
+ * Attaches a newly created latch to the shared "unnamed" profile.
+ * Called by createLatch.
+ */
+void registerLatch(Latch *latch) {
+#if LATCH_PROFILING
+    latch->profile = profileFor("unnamed");
+#else
+    (void) latch;
+#endif
+}
+
+/*
+ * Names a latch for contention profiling, e.g. nameLatch(latch, "pool frame %d", i).
+ * Latches sharing a name share their counters.
+ *
+ * Parameters:
+ * - latch: The latch to name, after createLatch.
+ * - format: printf-style format of the name.
+ */
+void nameLatch(Latch *latch, const char *format, ...) {
+#if LATCH_PROFILING
+    char name[LATCH_NAME_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(name, sizeof(name), format, args);
+    va_end(args);
+    latch->profile = profileFor(name);
+#else
+    (void) latch;
+    (void) format;
+#endif
+}
+
+/*
+ * Counts one acquisition of a latch. A non-zero wait marks it as contended.
+ * Called by lockLatchForRead and lockLatchForWrite.
+ */
+void recordLatchWait(Latch *latch, uint64_t waitNanos) {
+#if LATCH_PROFILING
+    LatchProfile *profile = latch->profile;
+    if (profile == NULL) {
+        return;
+    }
+    atomic_fetch_add_explicit(&profile->acquisitions, 1, memory_order_relaxed);
+    if (waitNanos == 0) {
+        return;
+    }
+    atomic_fetch_add_explicit(&profile->contended, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&profile->waitNanos, waitNanos, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&profile->maxWaitNanos, memory_order_relaxed);
+    while (waitNanos > max
+           && !atomic_compare_exchange_weak_explicit(&profile->maxWaitNanos, &max, waitNanos,
+                                                     memory_order_relaxed, memory_order_relaxed)) {
+    }
+#else
+    (void) latch;
+    (void) waitNanos;
+#endif
+}
+
+/*
+ * Copies the counters of the latches with the given name.
+ *
+ * Returns:
+ * - RC_OK on success.
+ * - RC_INVALID_INPUT if an argument is NULL.
+ * - RC_INVALID_NAME if no latch has that name or profiling is disabled.
+ */
+RC getLatchStats(const char *name, LatchStats *stats) {
+    if (name == NULL || stats == NULL) {
+        return RC_INVALID_INPUT;
+    }
+#if LATCH_PROFILING
+    RC rc = RC_INVALID_NAME;
+    pthread_mutex_lock(&latchRegistryMutex);
+    for (LatchProfile *profile = latchProfiles; profile != NULL; profile = profile->next) {
+        if (strcmp(profile->name, name) == 0) {
+            copyLatchStats(profile, stats);
+            rc = RC_OK;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&latchRegistryMutex);
+    return rc;
+#else
+    return RC_INVALID_NAME;
+#endif
+}
+
+/*
+ * Clears the counters of every latch, e.g. after a warm-up phase.
+ */
+void resetLatchStats(void) {
+#if LATCH_PROFILING
+    pthread_mutex_lock(&latchRegistryMutex);
+    for (LatchProfile *profile = latchProfiles; profile != NULL; profile = profile->next) {
+        atomic_store_explicit(&profile->acquisitions, 0, memory_order_relaxed);
+        atomic_store_explicit(&profile->contended, 0, memory_order_relaxed);
+        atomic_store_explicit(&profile->waitNanos, 0, memory_order_relaxed);
+        atomic_store_explicit(&profile->maxWaitNanos, 0, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&latchRegistryMutex);
+#endif
+}
+
+/*
+ * Prints one line per named latch that was acquired, hottest first by total
+ * wait time, with acquisitions, contended acquisitions and wait times in microseconds.
+ */
+void printLatchReport(FILE *out) {
+#if LATCH_PROFILING
+    pthread_mutex_lock(&latchRegistryMutex);
+    int count = 0;
+    for (LatchProfile *profile = latchProfiles; profile != NULL; profile = profile->next) {
+        count++;
+    }
+    LatchStats *stats = malloc(sizeof(LatchStats) * (count > 0 ? count : 1));
+    if (stats == NULL) {
+        pthread_mutex_unlock(&latchRegistryMutex);
+        return;
+    }
+    int used = 0;
+    for (LatchProfile *profile = latchProfiles; profile != NULL; profile = profile->next) {
+        copyLatchStats(profile, &stats[used]);
+        if (stats[used].acquisitions > 0) {
+            used++;
+        }
+    }
+    pthread_mutex_unlock(&latchRegistryMutex);
+
+    qsort(stats, used, sizeof(LatchStats), compareLatchStatsByWait);
+
+    fprintf(out, "%-32s %12s %10s %12s %12s\n", "latch", "acquired", "contended", "wait us", "max wait us");
+    for (int i = 0; i < used; i++) {
+        fprintf(out, "%-32s %12llu %10llu %12.2f %12.2f\n", stats[i].name,
+                (unsigned long long) stats[i].acquisitions,
+                (unsigned long long) stats[i].contended,
+                stats[i].waitNanos / 1000.0,
+                stats[i].maxWaitNanos / 1000.0);
+    }
+    free(stats);
+#else
+    fprintf(out, "latch profiling disabled, rebuild with LATCH_PROFILING=1\n");
+#endif
+}
@@ -0,0 +1,243 @@
+#include "latency.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-thread counters. Only the owning thread increments them; readers merge
+// all threads with relaxed loads, so recording never takes a lock.
+typedef struct LatencyThread {
+	_Atomic uint64_t count[LAT_NUM_OPS];
+	_Atomic uint64_t sum[LAT_NUM_OPS];
+	_Atomic uint64_t max[LAT_NUM_OPS];
+	_Atomic uint64_t buckets[LAT_NUM_OPS][LATENCY_NUM_BUCKETS];
+	struct LatencyThread *next;
+} LatencyThread;
+
+// Lock-free list of every thread that ever recorded a latency
+static _Atomic(LatencyThread *) latencyThreads = NULL;
+static __thread LatencyThread *threadLatency = NULL;
+
+static const char *latencyOpNames[LAT_NUM_OPS] = {
+	[LAT_PIN_HIT] = "pinPage hit",
+	[LAT_PIN_MISS] = "pinPage miss",
+	[LAT_READ_BLOCK] = "readBlock",
+	[LAT_WRITE_BLOCK] = "writeBlock",
+	[LAT_INSERT_RECORD] = "insertRecord",
+	[LAT_GET_RECORD] = "getRecord",
+	[LAT_UPDATE_RECORD] = "updateRecord",
+	[LAT_SCAN_NEXT] = "next",
+};
+
+// Creates the calling thread's counters and pushes them onto the global list
+static LatencyThread *
+createLatencyThread (void)
+{
+	LatencyThread *thread = (LatencyThread *) calloc(1, sizeof(LatencyThread));
+	if (thread == NULL)
+		return NULL;
+
+	LatencyThread *first = atomic_load(&latencyThreads);
+	do {
+		thread->next = first;
+	} while (!atomic_compare_exchange_weak(&latencyThreads, &first, thread));
+
+	return thread;
+}
+
+// Adds to a counter owned by the calling thread without a locked instruction
+static inline void
+addRelaxed (_Atomic uint64_t *counter, uint64_t value)
+{
+	atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+			memory_order_relaxed);
+}
+
+// Maps a latency in nanoseconds to its bucket
+static inline int
+bucketIndex (uint64_t nanos)
+{
+	if (nanos < LATENCY_SUB_BUCKETS)
+		return (int) nanos;
+
+	int exponent = 63 - __builtin_clzll(nanos);
+	if (exponent > LATENCY_MAX_EXPONENT)
+		return LATENCY_NUM_BUCKETS - 1;
+
+	int sub = (int) (nanos >> (exponent - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+	return (exponent - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Returns the highest latency that falls into a bucket
+static uint64_t
+bucketUpperBound (int index)
+{
+	if (index < LATENCY_SUB_BUCKETS)
+		return (uint64_t) index;
+
+	int exponent = index / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+	uint64_t sub = (uint64_t) (index % LATENCY_SUB_BUCKETS);
+	uint64_t width = 1ULL << (exponent - LATENCY_SUB_BUCKET_BITS);
+	return (LATENCY_SUB_BUCKETS + sub + 1) * width - 1;
+}
+
+/*
+ * Records one latency sample for an operation in the calling thread's
+ * histogram. Called through LATENCY_RECORD.
+ */
+void
+latencyRecord (LatencyOp op, uint64_t nanos)
+{
+	LatencyThread *thread = threadLatency;
+	if (thread == NULL)
+	{
+		thread = threadLatency = createLatencyThread();
+		if (thread == NULL)
+			return;
+	}
+
+	addRelaxed(&thread->count[op], 1);
+	addRelaxed(&thread->sum[op], nanos);
+	addRelaxed(&thread->buckets[op][bucketIndex(nanos)], 1);
+	if (nanos > atomic_load_explicit(&thread->max[op], memory_order_relaxed))
+		atomic_store_explicit(&thread->max[op], nanos, memory_order_relaxed);
+}
+
+/*
+ * Merges the histograms of every thread for one operation.
+ *
+ * Returns:
+ * - RC_OK on success, RC_RM_NULL_POINTER if histogram is NULL.
+ */
+RC
+latencySnapshot (LatencyOp op, LatencyHistogram *histogram)
+{
+	if (histogram == NULL)
+		return RC_RM_NULL_POINTER;
+
+	memset(histogram, 0, sizeof(LatencyHistogram));
+	for (LatencyThread *thread = atomic_load(&latencyThreads); thread != NULL; thread = thread->next)
+	{
+		histogram->count += atomic_load_explicit(&thread->count[op], memory_order_relaxed);
+		histogram->sum += atomic_load_explicit(&thread->sum[op], memory_order_relaxed);
+		uint64_t max = atomic_load_explicit(&thread->max[op], memory_order_relaxed);
+		if (max > histogram->max)
+			histogram->max = max;
+		for (int i = 0; i < LATENCY_NUM_BUCKETS; i++)
+			histogram->buckets[i] += atomic_load_explicit(&thread->buckets[op][i], memory_order_relaxed);
+	}
+	return RC_OK;
+}
+
+/*
+ * Returns the latency in nanoseconds below which the given percentage of
+ * samples fall (e.g. 99.9), rounded up to its bucket and capped at the
+ * largest sample. Returns 0 for an empty histogram.
+ */
+uint64_t
+latencyPercentile (const LatencyHistogram *histogram, double percentile)
+{
+	if (histogram->count == 0)
+		return 0;
+
+	// Rank of the sample that has the requested share of samples at or below it
+	uint64_t rank = (uint64_t) (percentile / 100.0 * histogram->count + 0.5);
+	if (rank < 1)
+		rank = 1;
+	if (rank > histogram->count)
+		rank = histogram->count;
+
+	uint64_t seen = 0;
+	for (int i = 0; i < LATENCY_NUM_BUCKETS; i++)
+	{
+		seen += histogram->buckets[i];
+		if (seen >= rank)
+		{
+			uint64_t bound = bucketUpperBound(i);
+			return bound < histogram->max ? bound : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+/*
+ * Adds one sample to a caller-owned histogram, e.g. one kept per client
+ * thread by a workload driver.
+ */
+void
+latencyHistogramAdd (LatencyHistogram *histogram, uint64_t nanos)
+{
+	histogram->count++;
+	histogram->sum += nanos;
+	if (nanos > histogram->max)
+		histogram->max = nanos;
+	histogram->buckets[bucketIndex(nanos)]++;
+}
+
+// Adds every sample of one caller-owned histogram to another
+void
+latencyHistogramMerge (LatencyHistogram *into, const LatencyHistogram *from)
+{
+	into->count += from->count;
+	into->sum += from->sum;
+	if (from->max > into->max)
+		into->max = from->max;
+	for (int i = 0; i < LATENCY_NUM_BUCKETS; i++)
+		into->buckets[i] += from->buckets[i];
+}
+
+/*
+ * Clears every thread's histograms, e.g. after a warm-up phase. Samples
+ * recorded concurrently with the reset may survive it.
+ */
+void
+latencyReset (void)
+{
+	for (LatencyThread *thread = atomic_load(&latencyThreads); thread != NULL; thread = thread->next)
+	{
+		for (int op = 0; op < LAT_NUM_OPS; op++)
+		{
+			atomic_store_explicit(&thread->count[op], 0, memory_order_relaxed);
+			atomic_store_explicit(&thread->sum[op], 0, memory_order_relaxed);
+			atomic_store_explicit(&thread->max[op], 0, memory_order_relaxed);
+			for (int i = 0; i < LATENCY_NUM_BUCKETS; i++)
+				atomic_store_explicit(&thread->buckets[op][i], 0, memory_order_relaxed);
+		}
+	}
+}
+
+/*
+ * Prints count, mean and tail latencies in microseconds for every operation
+ * that has samples.
+ */
+void
+latencyReport (FILE *out)
+{
+	LatencyHistogram histogram;
+
+	fprintf(out, "%-14s %10s %10s %10s %10s %10s %10s\n",
+			"operation", "count", "mean us", "p50 us", "p99 us", "p99.9 us", "max us");
+	for (int op = 0; op < LAT_NUM_OPS; op++)
+	{
+		latencySnapshot((LatencyOp) op, &histogram);
+		if (histogram.count == 0)
+			continue;
+		fprintf(out, "%-14s %10llu %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+				latencyOpName((LatencyOp) op),
+				(unsigned long long) histogram.count,
+				(double) histogram.sum / histogram.count / 1000.0,
+				latencyPercentile(&histogram, 50.0) / 1000.0,
+				latencyPercentile(&histogram, 99.0) / 1000.0,
+				latencyPercentile(&histogram, 99.9) / 1000.0,
+				histogram.max / 1000.0);
+	}
+}
+
+// Returns the printable name of an operation
+const char *
+latencyOpName (LatencyOp op)
+{
+	if (op >= 0 && op < LAT_NUM_OPS)
+		return latencyOpNames[op];
+	return "unknown";
+}
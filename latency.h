@@ -0,0 +1,75 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "dberror.h"
+
+/************************************************************
+ *                    latency histograms                    *
+ ************************************************************/
+// Operations are timed unless built with "make LATENCY=0".
+#ifndef LATENCY_HISTOGRAMS
+#define LATENCY_HISTOGRAMS 1
+#endif
+
+typedef enum LatencyOp {
+	LAT_PIN_HIT = 0,
+	LAT_PIN_MISS = 1,
+	LAT_READ_BLOCK = 2,
+	LAT_WRITE_BLOCK = 3,
+	LAT_INSERT_RECORD = 4,
+	LAT_GET_RECORD = 5,
+	LAT_UPDATE_RECORD = 6,
+	LAT_SCAN_NEXT = 7,
+	LAT_NUM_OPS
+} LatencyOp;
+
+// Log-linear buckets: values below 16 ns get one bucket each, every higher
+// power of two is split into 16 sub-buckets, so a bucket never spans more
+// than 1/16 of its lower bound. Values from 2^40 ns up share the last bucket.
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_EXPONENT 39
+#define LATENCY_NUM_BUCKETS ((LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 2) * LATENCY_SUB_BUCKETS)
+
+// Histogram of one operation, merged over all threads
+typedef struct LatencyHistogram {
+	uint64_t count;
+	uint64_t sum;  // nanoseconds
+	uint64_t max;  // nanoseconds
+	uint64_t buckets[LATENCY_NUM_BUCKETS];
+} LatencyHistogram;
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+extern void latencyRecord (LatencyOp op, uint64_t nanos);
+extern RC latencySnapshot (LatencyOp op, LatencyHistogram *histogram);
+extern uint64_t latencyPercentile (const LatencyHistogram *histogram, double percentile);
+extern void latencyHistogramAdd (LatencyHistogram *histogram, uint64_t nanos);
+extern void latencyHistogramMerge (LatencyHistogram *into, const LatencyHistogram *from);
+extern void latencyReset (void);
+extern void latencyReport (FILE *out);
+extern const char *latencyOpName (LatencyOp op);
+
+// Current CLOCK_MONOTONIC time in nanoseconds
+static inline uint64_t
+latencyNow (void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+}
+
+#if LATENCY_HISTOGRAMS
+#define LATENCY_START(name) uint64_t name = latencyNow()
+#define LATENCY_RECORD(op, name) latencyRecord((op), latencyNow() - (name))
+#else
+#define LATENCY_START(name)
+#define LATENCY_RECORD(op, name) do { } while (0)
+#endif
+
+#endif // LATENCY_H
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "loader.h"
+#include "record_mgr.h"
+
+#define LOAD_TABLE_MAX_ATTRS 64
+
+// Parses "name:type[:length],..." with the types int, float, bool, string and varchar
+static Schema *
+parseSchema (char *spec)
+{
+	char *names[LOAD_TABLE_MAX_ATTRS];
+	DataType types[LOAD_TABLE_MAX_ATTRS];
+	int lengths[LOAD_TABLE_MAX_ATTRS];
+	int key = 0;
+	int numAttr = 0;
+
+	for (char *attr = strtok(spec, ","); attr != NULL; attr = strtok(NULL, ","))
+	{
+		if (numAttr == LOAD_TABLE_MAX_ATTRS)
+			return NULL;
+		char *type = strchr(attr, ':');
+		if (type == NULL)
+			return NULL;
+		*type++ = '\0';
+		char *length = strchr(type, ':');
+		if (length != NULL)
+			*length++ = '\0';
+
+		lengths[numAttr] = 0;
+		if (strcmp(type, "int") == 0)
+			types[numAttr] = DT_INT;
+		else if (strcmp(type, "float") == 0)
+			types[numAttr] = DT_FLOAT;
+		else if (strcmp(type, "bool") == 0)
+			types[numAttr] = DT_BOOL;
+		else if ((strcmp(type, "string") == 0 || strcmp(type, "varchar") == 0)
+				&& length != NULL && atoi(length) > 0)
+		{
+			types[numAttr] = type[0] == 's' ? DT_STRING : DT_VARCHAR;
+			lengths[numAttr] = atoi(length);
+		}
+		else
+			return NULL;
+		names[numAttr++] = attr;
+	}
+	if (numAttr == 0)
+		return NULL;
+
+	// The first attribute is the key, as in the test tables
+	return createSchema(numAttr, names, types, lengths, 1, &key);
+}
+
+/*
+ * Bulk loads a CSV or binary row file into a table with the direct-path
+ * loader, creating the table first when a schema is given.
+ *
+ * Usage: load_table [--binary] [--header] [--schema <spec>] <table> <input>
+ */
+int
+main (int argc, char **argv)
+{
+	bool binary = false;
+	bool header = false;
+	char *schemaSpec = NULL;
+	int arg = 1;
+
+	for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++)
+	{
+		if (strcmp(argv[arg], "--binary") == 0)
+			binary = true;
+		else if (strcmp(argv[arg], "--header") == 0)
+			header = true;
+		else if (strcmp(argv[arg], "--schema") == 0 && arg + 1 < argc)
+			schemaSpec = argv[++arg];
+		else
+			break;
+	}
+	if (argc - arg != 2)
+	{
+		fprintf(stderr, "usage: %s [--binary] [--header] [--schema name:type[:length],...] <table> <input>\n"
+				"  types: int, float, bool, string:<length>, varchar:<max length>\n", argv[0]);
+		return 1;
+	}
+	char *table = argv[arg];
+	char *input = argv[arg + 1];
+
+	initRecordManager(NULL);
+	if (schemaSpec != NULL)
+	{
+		if (access(table, F_OK) == 0)
+		{
+			fprintf(stderr, "%s already exists; drop --schema to append to it\n", table);
+			return 1;
+		}
+		Schema *schema = parseSchema(schemaSpec);
+		if (schema == NULL)
+		{
+			fprintf(stderr, "bad schema %s\n", schemaSpec);
+			return 1;
+		}
+		RC rc = createTable(table, schema);
+		freeSchema(schema);
+		if (rc != RC_OK)
+		{
+			fprintf(stderr, "cannot create %s: error %d\n", table, rc);
+			return 1;
+		}
+	}
+
+	struct timespec start, end;
+	long rows = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	RC rc = binary ? loadTableFromBinary(table, input, &rows) : loadTableFromCsv(table, input, header, &rows);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("loaded %ld rows into %s in %.3f s (%.0f rows/s)\n", rows, table, seconds,
+			seconds > 0 ? rows / seconds : 0.0);
+	if (rc != RC_OK)
+	{
+		fprintf(stderr, "load stopped after %ld rows: error %d\n", rows, rc);
+		return 1;
+	}
+	shutdownRecordManager();
+	return 0;
+}
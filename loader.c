@@ -0,0 +1,169 @@
+#include "loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "record_mgr.h"
+
+typedef struct LoaderInput {
+	FILE *file;
+	char *line;                   // CSV only: current line and its capacity
+	size_t lineCapacity;
+} LoaderInput;
+
+static RC
+openInput (LoaderInput *input, const char *fileName)
+{
+	memset(input, 0, sizeof(LoaderInput));
+	input->file = fopen(fileName, "rb");
+	if (input->file == NULL)
+		return RC_FILE_NOT_FOUND;
+	setvbuf(input->file, NULL, _IOFBF, LOADER_BUFFER_SIZE);
+	return RC_OK;
+}
+
+static void
+closeInput (LoaderInput *input)
+{
+	fclose(input->file);
+	free(input->line);
+}
+
+// Parses one CSV field into its place in the row, like stringToValue
+static void
+parseField (char *field, Schema *schema, int attrNum, char *data)
+{
+	int intV;
+	float floatV;
+	bool boolV;
+
+	switch (schema->dataTypes[attrNum])
+	{
+	case DT_INT:
+		intV = atoi(field);
+		memcpy(data, &intV, sizeof(int));
+		break;
+	case DT_FLOAT:
+		floatV = atof(field);
+		memcpy(data, &floatV, sizeof(float));
+		break;
+	case DT_BOOL:
+		boolV = field[0] == 't' ? TRUE : FALSE;
+		memcpy(data, &boolV, sizeof(bool));
+		break;
+	case DT_STRING:
+	case DT_VARCHAR:
+		strncpy(data, field, schema->typeLength[attrNum]);
+		break;
+	case DT_NULL:
+		// NULL fields are \N and never reach here
+		break;
+	}
+}
+
+static RC
+nextCsvRow (void *context, Schema *schema, char *data)
+{
+	LoaderInput *input = (LoaderInput *) context;
+	int *offsets = schema->attrOffsets;
+	ssize_t length;
+
+	// Skip blank lines
+	do
+	{
+		length = getline(&input->line, &input->lineCapacity, input->file);
+		if (length < 0)
+			return ferror(input->file) ? RC_READ_FAILED : RC_RM_NO_MORE_TUPLES;
+		while (length > 0 && (input->line[length - 1] == '\n' || input->line[length - 1] == '\r'))
+			input->line[--length] = '\0';
+	} while (length == 0);
+
+	char *field = input->line;
+	memset(data, 0, NULL_BITMAP_SIZE(schema->numAttr));
+	for (int i = 0; i < schema->numAttr; i++)
+	{
+		char *end = strchr(field, ',');
+		if ((end == NULL) != (i == schema->numAttr - 1))
+			return RC_RM_DATA_SIZE_ERROR;
+		if (end != NULL)
+			*end = '\0';
+		if (strcmp(field, LOADER_NULL_FIELD) == 0)
+		{
+			data[i / 8] |= 1 << (i % 8);
+			memset(data + offsets[i], 0, offsets[i + 1] - offsets[i]);
+		}
+		else
+			parseField(field, schema, i, data + offsets[i]);
+		field = end + 1;
+	}
+	return RC_OK;
+}
+
+static RC
+nextBinaryRow (void *context, Schema *schema, char *data)
+{
+	LoaderInput *input = (LoaderInput *) context;
+
+	size_t recordSize = getRecordSize(schema);
+	size_t read = fread(data, 1, recordSize, input->file);
+	if (read == recordSize)
+		return RC_OK;
+	if (ferror(input->file))
+		return RC_READ_FAILED;
+	return read == 0 ? RC_RM_NO_MORE_TUPLES : RC_RM_DATA_SIZE_ERROR;
+}
+
+/*
+ * Appends the rows of a CSV file to a closed table with bulkLoadTable.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_NOT_FOUND if the file cannot be opened,
+ *   RC_RM_DATA_SIZE_ERROR for a line without one field per attribute (the
+ *   rows before it are loaded), or any error of bulkLoadTable.
+ */
+RC
+loadTableFromCsv (char *name, const char *fileName, bool hasHeader, long *rowsLoaded)
+{
+	LoaderInput input;
+
+	if (rowsLoaded != NULL)
+		*rowsLoaded = 0;
+	RC rc = openInput(&input, fileName);
+	if (rc != RC_OK)
+		return rc;
+
+	// An empty file has no header either
+	if (hasHeader && getline(&input.line, &input.lineCapacity, input.file) < 0 && ferror(input.file))
+		rc = RC_READ_FAILED;
+	else
+		rc = bulkLoadTable(name, nextCsvRow, &input, rowsLoaded);
+
+	closeInput(&input);
+	return rc;
+}
+
+/*
+ * Appends the rows of a binary row file to a closed table with bulkLoadTable.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_NOT_FOUND if the file cannot be opened,
+ *   RC_RM_DATA_SIZE_ERROR if the file ends inside a row (the whole rows
+ *   before it are loaded), or any error of bulkLoadTable.
+ */
+RC
+loadTableFromBinary (char *name, const char *fileName, long *rowsLoaded)
+{
+	LoaderInput input;
+
+	if (rowsLoaded != NULL)
+		*rowsLoaded = 0;
+	RC rc = openInput(&input, fileName);
+	if (rc != RC_OK)
+		return rc;
+
+	rc = bulkLoadTable(name, nextBinaryRow, &input, rowsLoaded);
+
+	closeInput(&input);
+	return rc;
+}
@@ -0,0 +1,24 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "dberror.h"
+#include "dt.h"
+
+/************************************************************
+ *                    direct-path loader                    *
+ ************************************************************/
+// Row sources for bulkLoadTable. A CSV file holds one row per line with the
+// attributes in schema order, parsed like stringToValue parses a value of
+// the attribute's type; strings longer than the attribute are cut. A binary
+// row file holds getRecordSize bytes per row, laid out like Record.data.
+// A CSV field of just \N is a NULL.
+#define LOADER_BUFFER_SIZE (1 << 20)
+#define LOADER_NULL_FIELD "\\N"
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+extern RC loadTableFromCsv (char *name, const char *fileName, bool hasHeader, long *rowsLoaded);
+extern RC loadTableFromBinary (char *name, const char *fileName, long *rowsLoaded);
+
+#endif // LOADER_H
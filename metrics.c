@@ -0,0 +1,325 @@
+#include "metrics.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "latency.h"
+#include "record_mgr.h"
+
+// Watched sources. The lock is held for a whole snapshot, so forgetting a
+// source or replacing its memory waits until no snapshot reads it.
+static pthread_mutex_t metricsSourcesMutex = PTHREAD_MUTEX_INITIALIZER;
+static BM_BufferPool *metricsPools[METRICS_MAX_POOLS];
+static RM_TableData *metricsTables[METRICS_MAX_TABLES];
+static unsigned long metricsSequence = 0;
+
+// Background reporter
+static pthread_mutex_t reporterMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reporterCond = PTHREAD_COND_INITIALIZER;
+static pthread_t reporterThread;
+static bool reporterRunning = false;
+static bool reporterStopping = false;
+static FILE *reporterFile = NULL;
+static int reporterIntervalMillis = 0;
+
+static const char *metricsStrategyNames[RS_NUM_STRATEGIES] = { "FIFO", "LRU", "CLOCK", "LFU", "LRU-K" };
+
+// Adds a pointer to the first free slot of a source array
+static RC
+watchSource (void **sources, int capacity, void *source)
+{
+	RC rc = RC_NO_FREE_SLOT_FOUND;
+
+	pthread_mutex_lock(&metricsSourcesMutex);
+	for (int i = 0; i < capacity; i++)
+		if (sources[i] == source)
+			rc = RC_OK;
+	for (int i = 0; i < capacity && rc != RC_OK; i++)
+		if (sources[i] == NULL)
+		{
+			sources[i] = source;
+			rc = RC_OK;
+		}
+	pthread_mutex_unlock(&metricsSourcesMutex);
+	return rc;
+}
+
+static void
+forgetSource (void **sources, int capacity, void *source)
+{
+	pthread_mutex_lock(&metricsSourcesMutex);
+	for (int i = 0; i < capacity; i++)
+		if (sources[i] == source)
+			sources[i] = NULL;
+	pthread_mutex_unlock(&metricsSourcesMutex);
+}
+
+/*
+ * Adds an initialized buffer pool to every later snapshot until it is shut
+ * down.
+ *
+ * Returns:
+ * - RC_OK on success, RC_BP_INIT_ERROR if the pool is not initialized,
+ *   RC_NO_FREE_SLOT_FOUND if METRICS_MAX_POOLS pools are already watched.
+ */
+RC
+metricsWatchPool (BM_BufferPool *bm)
+{
+	if (bm == NULL || bm->mgmtData == NULL)
+		return RC_BP_INIT_ERROR;
+	return watchSource((void **) metricsPools, METRICS_MAX_POOLS, bm);
+}
+
+/*
+ * Adds an open table and its buffer pool to every later snapshot until the
+ * table is closed.
+ *
+ * Returns:
+ * - RC_OK on success, RC_RM_TABLE_ERROR if the table is not open,
+ *   RC_NO_FREE_SLOT_FOUND if no slot is left for the table or its pool.
+ */
+RC
+metricsWatchTable (RM_TableData *rel)
+{
+	if (rel == NULL || rel->managementData == NULL)
+		return RC_RM_TABLE_ERROR;
+
+	RC rc = metricsWatchPool(&((RM_managementData *) rel->managementData)->bm);
+	if (rc != RC_OK)
+		return rc;
+	return watchSource((void **) metricsTables, METRICS_MAX_TABLES, rel);
+}
+
+// Called by shutdownBufferPool before the pool's memory is released
+void
+metricsForgetPool (BM_BufferPool *bm)
+{
+	forgetSource((void **) metricsPools, METRICS_MAX_POOLS, bm);
+}
+
+// Called by closeTable before the table's memory is released
+void
+metricsForgetTable (RM_TableData *rel)
+{
+	forgetSource((void **) metricsTables, METRICS_MAX_TABLES, rel);
+}
+
+void
+metricsLockSources (void)
+{
+	pthread_mutex_lock(&metricsSourcesMutex);
+}
+
+void
+metricsUnlockSources (void)
+{
+	pthread_mutex_unlock(&metricsSourcesMutex);
+}
+
+// Writes the frame table, counters and file I/O of one pool
+static void
+writePoolMetrics (FILE *out, BM_BufferPool *bm)
+{
+	Frames *frames = (Frames *) bm->mgmtData;
+	BM_Stats stats = bm->stats;
+	SM_FileIOStats io = bm->fileHandle.ioStats;
+	int occupied = 0, dirty = 0, pinned = 0, fixTotal = 0;
+	long evictions = stats.resizeEvictions;
+
+	for (int i = 0; i < bm->numPages; i++)
+	{
+		if (frames[i].pageNumber == NO_PAGE)
+			continue;
+		occupied++;
+		dirty += frames[i].dirty ? 1 : 0;
+		pinned += frames[i].fix_cnt > 0 ? 1 : 0;
+		fixTotal += frames[i].fix_cnt;
+	}
+	for (int i = 0; i < RS_NUM_STRATEGIES; i++)
+		evictions += stats.evictions[i];
+
+	fprintf(out, "{\"file\": \"%s\", \"strategy\": \"%s\", \"frames\": %d, \"occupied\": %d, "
+			"\"dirty\": %d, \"pinned\": %d, \"fix_total\": %d, \"contents\": [",
+			bm->pageFile, metricsStrategyNames[bm->strategy], bm->numPages,
+			occupied, dirty, pinned, fixTotal);
+	for (int i = 0; i < bm->numPages; i++)
+		fprintf(out, "%s[%d, %d, %d]", i == 0 ? "" : ", ",
+				frames[i].pageNumber, frames[i].fix_cnt, frames[i].dirty ? 1 : 0);
+	fprintf(out, "], \"hits\": %ld, \"misses\": %ld, \"evictions\": %ld, "
+			"\"sync_writebacks\": %ld, \"background_writebacks\": %ld, \"pin_failures\": %ld, "
+			"\"reads\": %ld, \"writes\": %ld, \"peak_pinned\": %d, "
+			"\"io\": {\"pages_read\": %ld, \"pages_written\": %ld, \"read_calls\": %ld, "
+			"\"write_calls\": %ld, \"extensions\": %ld, \"io_ms\": %.3f}}",
+			stats.hits, stats.misses, evictions, stats.syncWritebacks, stats.backgroundWritebacks,
+			stats.pinFailures, stats.reads, stats.writes, stats.peakPinnedFrames,
+			io.pagesRead, io.pagesWritten, io.readCalls, io.writeCalls, io.extensions,
+			io.ioNanos / 1e6);
+}
+
+/*
+ * Appends one snapshot line to a stream and flushes it. Counters are read
+ * without the pool's latches, so a snapshot taken while other threads work
+ * is consistent per value but not across values.
+ *
+ * Returns:
+ * - RC_OK on success, RC_RM_NULL_POINTER if out is NULL, RC_WRITE_FAILED if
+ *   the line could not be written.
+ */
+RC
+writeMetricsSnapshot (FILE *out)
+{
+	LatencyHistogram histogram;
+	struct timespec now;
+	bool first;
+
+	if (out == NULL)
+		return RC_RM_NULL_POINTER;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	pthread_mutex_lock(&metricsSourcesMutex);
+	fprintf(out, "{\"ts_ms\": %lld, \"seq\": %lu, \"pools\": [",
+			(long long) now.tv_sec * 1000 + now.tv_nsec / 1000000, metricsSequence++);
+	first = true;
+	for (int i = 0; i < METRICS_MAX_POOLS; i++)
+	{
+		if (metricsPools[i] == NULL || metricsPools[i]->mgmtData == NULL)
+			continue;
+		fprintf(out, "%s", first ? "" : ", ");
+		writePoolMetrics(out, metricsPools[i]);
+		first = false;
+	}
+
+	fprintf(out, "], \"tables\": [");
+	first = true;
+	for (int i = 0; i < METRICS_MAX_TABLES; i++)
+	{
+		RM_TableData *rel = metricsTables[i];
+		if (rel == NULL || rel->managementData == NULL)
+			continue;
+		fprintf(out, "%s{\"name\": \"%s\", \"pages\": %d, \"tuples\": %d}", first ? "" : ", ",
+				rel->name, ((RM_managementData *) rel->managementData)->numPages, getNumTuples(rel));
+		first = false;
+	}
+	pthread_mutex_unlock(&metricsSourcesMutex);
+
+	fprintf(out, "], \"latency\": [");
+	first = true;
+	for (int op = 0; op < LAT_NUM_OPS; op++)
+	{
+		latencySnapshot((LatencyOp) op, &histogram);
+		if (histogram.count == 0)
+			continue;
+		fprintf(out, "%s{\"op\": \"%s\", \"count\": %llu, \"mean_us\": %.3f, \"p50_us\": %.3f, "
+				"\"p99_us\": %.3f, \"p999_us\": %.3f, \"max_us\": %.3f}",
+				first ? "" : ", ", latencyOpName((LatencyOp) op),
+				(unsigned long long) histogram.count,
+				(double) histogram.sum / histogram.count / 1000.0,
+				latencyPercentile(&histogram, 50.0) / 1000.0,
+				latencyPercentile(&histogram, 99.0) / 1000.0,
+				latencyPercentile(&histogram, 99.9) / 1000.0,
+				histogram.max / 1000.0);
+		first = false;
+	}
+	fprintf(out, "]}\n");
+
+	return fflush(out) == 0 && !ferror(out) ? RC_OK : RC_WRITE_FAILED;
+}
+
+// Body of the reporter thread: one snapshot per interval until stopped
+static void *
+reporterMain (void *arg)
+{
+	struct timespec deadline;
+
+	(void) arg;
+	pthread_mutex_lock(&reporterMutex);
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	while (!reporterStopping)
+	{
+		deadline.tv_sec += reporterIntervalMillis / 1000;
+		deadline.tv_nsec += (long) (reporterIntervalMillis % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000)
+		{
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+		while (!reporterStopping
+				&& pthread_cond_timedwait(&reporterCond, &reporterMutex, &deadline) != ETIMEDOUT)
+			;
+		if (!reporterStopping)
+			writeMetricsSnapshot(reporterFile);
+	}
+	pthread_mutex_unlock(&reporterMutex);
+	return NULL;
+}
+
+/*
+ * Starts a thread that appends a snapshot to a file every intervalMillis
+ * milliseconds, e.g. for a collector that tails the file.
+ *
+ * Returns:
+ * - RC_OK on success, RC_INVALID_INPUT for a bad argument or a reporter that
+ *   is already running, RC_FILE_OPEN_FAILED if the file cannot be opened,
+ *   RC_UNEXPECTED_ACTION if the thread cannot be created.
+ */
+RC
+startMetricsReporter (const char *fileName, int intervalMillis)
+{
+	if (fileName == NULL || intervalMillis <= 0)
+		return RC_INVALID_INPUT;
+
+	pthread_mutex_lock(&reporterMutex);
+	if (reporterRunning)
+	{
+		pthread_mutex_unlock(&reporterMutex);
+		return RC_INVALID_INPUT;
+	}
+	reporterFile = fopen(fileName, "a");
+	if (reporterFile == NULL)
+	{
+		pthread_mutex_unlock(&reporterMutex);
+		return RC_FILE_OPEN_FAILED;
+	}
+	reporterIntervalMillis = intervalMillis;
+	reporterStopping = false;
+	if (pthread_create(&reporterThread, NULL, reporterMain, NULL) != 0)
+	{
+		fclose(reporterFile);
+		reporterFile = NULL;
+		pthread_mutex_unlock(&reporterMutex);
+		return RC_UNEXPECTED_ACTION;
+	}
+	reporterRunning = true;
+	pthread_mutex_unlock(&reporterMutex);
+	return RC_OK;
+}
+
+/*
+ * Stops the reporter thread, writes a final snapshot and closes the file.
+ *
+ * Returns:
+ * - RC_OK on success, RC_INVALID_INPUT if no reporter is running.
+ */
+RC
+stopMetricsReporter (void)
+{
+	pthread_mutex_lock(&reporterMutex);
+	if (!reporterRunning)
+	{
+		pthread_mutex_unlock(&reporterMutex);
+		return RC_INVALID_INPUT;
+	}
+	reporterStopping = true;
+	pthread_cond_signal(&reporterCond);
+	pthread_mutex_unlock(&reporterMutex);
+
+	pthread_join(reporterThread, NULL);
+
+	RC rc = writeMetricsSnapshot(reporterFile);
+	fclose(reporterFile);
+	reporterFile = NULL;
+	reporterRunning = false;
+	return rc;
+}
@@ -0,0 +1,39 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "tables.h"
+
+/************************************************************
+ *                    metrics snapshots                     *
+ ************************************************************/
+// A snapshot is one JSON line covering every watched buffer pool (frame
+// occupancy, dirty and pin counts, counters, file I/O), every watched table
+// (pages and tuples) and the latency histograms. Snapshots are written
+// straight to the stream, so taking one never allocates.
+#define METRICS_MAX_POOLS 8
+#define METRICS_MAX_TABLES 8
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+// Watched sources; a pool or table is forgotten when it is shut down or closed
+extern RC metricsWatchPool (BM_BufferPool *bm);
+extern RC metricsWatchTable (RM_TableData *rel);
+extern void metricsForgetPool (BM_BufferPool *bm);
+extern void metricsForgetTable (RM_TableData *rel);
+
+// Held while a watched pool or table replaces memory a snapshot reads
+extern void metricsLockSources (void);
+extern void metricsUnlockSources (void);
+
+extern RC writeMetricsSnapshot (FILE *out);
+
+// Background thread appending a snapshot to a file every interval
+extern RC startMetricsReporter (const char *fileName, int intervalMillis);
+extern RC stopMetricsReporter (void);
+
+#endif // METRICS_H
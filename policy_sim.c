@@ -0,0 +1,478 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer_mgr.h"
+
+/*
+ * Offline replacement-policy simulator. Replays a page reference trace written
+ * by enablePageTrace against every ReplacementStrategy over a range of pool
+ * sizes and prints the hit ratio curves, plus the dirty write-backs each
+ * policy would have caused.
+ *
+ * Usage: policy_sim <trace> [--sizes n,n,...] [--k K]
+ *   --sizes  pool sizes to simulate (default powers of two up to the number
+ *            of distinct pages in the trace)
+ *   --k      history depth of LRU-K (default BM_LRU_K_DEFAULT, at most
+ *            BM_LRU_K_MAX, as for a pool's stratParam)
+ *
+ * FIFO, LRU and LRU-K pick victims as pinPage does: a missing page goes to the
+ * first empty frame, else FIFO takes the first unpinned frame from the load
+ * count modulo the pool size, LRU the least recently pinned unpinned frame
+ * and LRU-K the unpinned frame with the oldest K-th most recent pin. FIFO
+ * counts loads from the start of the trace. The pool counts loads since the
+ * last initBufferPool, including the pages a warm restart reloads and the
+ * reads of any other open pool, so in those cases its rotation starts
+ * elsewhere. CLOCK and LFU are not implemented by the buffer pool; their
+ * columns are marked as simulation only.
+ *
+ * Pins and unpins are replayed, so pinned pages are never evicted; a pin that
+ * finds every frame pinned counts as a failure. A page counts as modified
+ * when any event on it while resident carries the dirty flag.
+ */
+
+#define SIM_MAX_SIZES 32
+
+static const char *strategyNames[RS_NUM_STRATEGIES] = {
+	[RS_FIFO] = "FIFO",
+	[RS_LRU] = "LRU",
+	[RS_CLOCK] = "CLOCK*",
+	[RS_LFU] = "LFU*",
+	[RS_LRU_K] = "LRU-K",
+};
+
+// A trace with page numbers mapped to dense ids [0, numPages)
+typedef struct SimTrace {
+	int *pages;
+	unsigned char *kinds;
+	unsigned char *dirty;
+	long numEvents;
+	long numPins;
+	int numPages;
+} SimTrace;
+
+// Simulated pool; a frame is empty while its page is -1
+typedef struct SimPool {
+	int numFrames;
+	int k;
+	int *page;
+	int *fixCount;
+	bool *dirty;
+	bool *refBit;
+	long *lastUse;
+	long *refCount;
+	long *history;     // last k reference times per frame, most recent first
+	int *frameOf;      // frame of every page, or -1
+	int clockHand;
+	long loads;        // pages loaded, the FIFO position as readFromDisk is in the pool
+} SimPool;
+
+typedef struct SimResult {
+	long hits;
+	long misses;
+	long writebacks;
+	long failures;
+} SimResult;
+
+/*
+ * Reads a whole trace into memory and maps its page numbers to dense ids.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_OPEN_FAILED, RC_READ_NON_EXISTING_PAGE for a
+ *   malformed file or RC_MALLOC_ERROR otherwise.
+ */
+static RC
+loadTrace (const char *fileName, SimTrace *trace)
+{
+	FILE *file = fopen(fileName, "rb");
+	BM_TraceHeader header;
+
+	if (file == NULL)
+		return RC_FILE_OPEN_FAILED;
+	if (fread(&header, sizeof(header), 1, file) != 1
+			|| header.magic != BM_TRACE_MAGIC || header.version != BM_TRACE_VERSION)
+	{
+		fclose(file);
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long numEvents = (ftell(file) - (long) sizeof(header)) / (long) sizeof(BM_TraceEvent);
+	fseek(file, sizeof(header), SEEK_SET);
+
+	BM_TraceEvent *events = malloc(sizeof(BM_TraceEvent) * (numEvents > 0 ? numEvents : 1));
+	memset(trace, 0, sizeof(SimTrace));
+	trace->pages = malloc(sizeof(int) * (numEvents > 0 ? numEvents : 1));
+	trace->kinds = malloc(numEvents > 0 ? numEvents : 1);
+	trace->dirty = malloc(numEvents > 0 ? numEvents : 1);
+	if (events == NULL || trace->pages == NULL || trace->kinds == NULL || trace->dirty == NULL)
+	{
+		free(events);
+		fclose(file);
+		return RC_MALLOC_ERROR;
+	}
+	numEvents = (long) fread(events, sizeof(BM_TraceEvent), numEvents, file);
+	fclose(file);
+
+	int maxPage = -1;
+	for (long i = 0; i < numEvents; i++)
+		if (events[i].pageNum > maxPage)
+			maxPage = events[i].pageNum;
+
+	int *denseId = malloc(sizeof(int) * (maxPage + 1 > 0 ? maxPage + 1 : 1));
+	if (denseId == NULL)
+	{
+		free(events);
+		return RC_MALLOC_ERROR;
+	}
+	for (int p = 0; p <= maxPage; p++)
+		denseId[p] = -1;
+
+	for (long i = 0; i < numEvents; i++)
+	{
+		int pageNum = events[i].pageNum;
+		if (pageNum < 0)
+			continue;
+		if (denseId[pageNum] == -1)
+			denseId[pageNum] = trace->numPages++;
+		trace->pages[trace->numEvents] = denseId[pageNum];
+		trace->kinds[trace->numEvents] = events[i].kind;
+		trace->dirty[trace->numEvents] = events[i].dirty;
+		if (events[i].kind == BM_TRACE_PIN)
+			trace->numPins++;
+		trace->numEvents++;
+	}
+
+	free(denseId);
+	free(events);
+	return RC_OK;
+}
+
+static RC
+createPool (SimPool *pool, int numFrames, int numPages, int k)
+{
+	pool->numFrames = numFrames;
+	pool->k = k;
+	pool->clockHand = 0;
+	pool->loads = 0;
+	pool->page = malloc(sizeof(int) * numFrames);
+	pool->fixCount = calloc(numFrames, sizeof(int));
+	pool->dirty = calloc(numFrames, sizeof(bool));
+	pool->refBit = calloc(numFrames, sizeof(bool));
+	pool->lastUse = calloc(numFrames, sizeof(long));
+	pool->refCount = calloc(numFrames, sizeof(long));
+	pool->history = calloc((size_t) numFrames * k, sizeof(long));
+	pool->frameOf = malloc(sizeof(int) * (numPages > 0 ? numPages : 1));
+	if (pool->page == NULL || pool->fixCount == NULL || pool->dirty == NULL || pool->refBit == NULL
+			|| pool->lastUse == NULL || pool->refCount == NULL
+			|| pool->history == NULL || pool->frameOf == NULL)
+		return RC_MALLOC_ERROR;
+
+	for (int f = 0; f < numFrames; f++)
+		pool->page[f] = -1;
+	for (int p = 0; p < numPages; p++)
+		pool->frameOf[p] = -1;
+	return RC_OK;
+}
+
+static void
+freePool (SimPool *pool)
+{
+	free(pool->page);
+	free(pool->fixCount);
+	free(pool->dirty);
+	free(pool->refBit);
+	free(pool->lastUse);
+	free(pool->refCount);
+	free(pool->history);
+	free(pool->frameOf);
+}
+
+// Records a reference to the page in a frame at the given time
+static void
+touchFrame (SimPool *pool, int frame, long now)
+{
+	long *history = &pool->history[(size_t) frame * pool->k];
+
+	memmove(history + 1, history, sizeof(long) * (pool->k - 1));
+	history[0] = now;
+	pool->lastUse[frame] = now;
+	pool->refCount[frame]++;
+	pool->refBit[frame] = true;
+}
+
+// Returns true if frame a is a better victim than frame b under LRU-K
+static bool
+lruKBefore (SimPool *pool, int a, int b)
+{
+	// Pages with fewer than k references have an infinite backward distance
+	bool aShort = pool->refCount[a] < pool->k;
+	bool bShort = pool->refCount[b] < pool->k;
+
+	if (aShort != bShort)
+		return aShort;
+	if (aShort)
+		return pool->lastUse[a] < pool->lastUse[b];
+	return pool->history[(size_t) a * pool->k + pool->k - 1] < pool->history[(size_t) b * pool->k + pool->k - 1];
+}
+
+/*
+ * Picks the frame to receive a missing page: an empty frame if any, otherwise
+ * the unpinned frame the strategy would evict.
+ *
+ * Returns the frame, or -1 if every frame is pinned.
+ */
+static int
+chooseFrame (SimPool *pool, ReplacementStrategy strategy)
+{
+	int victim = -1;
+
+	for (int f = 0; f < pool->numFrames; f++)
+		if (pool->page[f] == -1)
+			return f;
+
+	if (strategy == RS_FIFO)
+	{
+		// Like FIFO in buffer_mgr.c, scan forward from the load count
+		int f = (int) (pool->loads % pool->numFrames);
+		for (int step = 0; step < pool->numFrames; step++, f = (f + 1) % pool->numFrames)
+			if (pool->fixCount[f] == 0)
+				return f;
+		return -1;
+	}
+
+	if (strategy == RS_CLOCK)
+	{
+		// Two sweeps clear every reference bit, so a third finds nothing new
+		for (int step = 0; step < 2 * pool->numFrames + 1; step++)
+		{
+			int f = pool->clockHand;
+			pool->clockHand = (pool->clockHand + 1) % pool->numFrames;
+			if (pool->fixCount[f] > 0)
+				continue;
+			if (!pool->refBit[f])
+				return f;
+			pool->refBit[f] = false;
+		}
+		return -1;
+	}
+
+	for (int f = 0; f < pool->numFrames; f++)
+	{
+		if (pool->fixCount[f] > 0)
+			continue;
+		if (victim == -1)
+		{
+			victim = f;
+			continue;
+		}
+		switch (strategy)
+		{
+			case RS_LFU:
+				if (pool->refCount[f] < pool->refCount[victim]
+						|| (pool->refCount[f] == pool->refCount[victim] && pool->lastUse[f] < pool->lastUse[victim]))
+					victim = f;
+				break;
+			case RS_LRU_K:
+				if (lruKBefore(pool, f, victim))
+					victim = f;
+				break;
+			default:
+				if (pool->lastUse[f] < pool->lastUse[victim])
+					victim = f;
+				break;
+		}
+	}
+	return victim;
+}
+
+// Replays a trace against one strategy and pool size
+static RC
+simulate (const SimTrace *trace, ReplacementStrategy strategy, int numFrames, int k, SimResult *result)
+{
+	SimPool pool;
+	long now = 0;
+
+	memset(result, 0, sizeof(SimResult));
+	if (createPool(&pool, numFrames, trace->numPages, k) != RC_OK)
+	{
+		freePool(&pool);
+		return RC_MALLOC_ERROR;
+	}
+
+	for (long i = 0; i < trace->numEvents; i++)
+	{
+		int page = trace->pages[i];
+		int frame = pool.frameOf[page];
+
+		if (trace->kinds[i] == BM_TRACE_UNPIN)
+		{
+			if (frame != -1 && pool.fixCount[frame] > 0)
+			{
+				pool.fixCount[frame]--;
+				pool.dirty[frame] |= trace->dirty[i];
+			}
+			continue;
+		}
+
+		now++;
+		if (frame != -1)
+		{
+			result->hits++;
+		}
+		else
+		{
+			frame = chooseFrame(&pool, strategy);
+			if (frame == -1)
+			{
+				result->failures++;
+				continue;
+			}
+			result->misses++;
+			pool.loads++;
+			if (pool.page[frame] != -1)
+			{
+				if (pool.dirty[frame])
+					result->writebacks++;
+				pool.frameOf[pool.page[frame]] = -1;
+			}
+			pool.page[frame] = page;
+			pool.frameOf[page] = frame;
+			pool.dirty[frame] = false;
+			pool.refCount[frame] = 0;
+			memset(&pool.history[(size_t) frame * k], 0, sizeof(long) * k);
+		}
+		pool.fixCount[frame]++;
+		pool.dirty[frame] |= trace->dirty[i];
+		touchFrame(&pool, frame, now);
+	}
+
+	freePool(&pool);
+	return RC_OK;
+}
+
+// Parses a comma separated list of pool sizes, returns how many were read
+static int
+parseSizes (const char *list, int *sizes)
+{
+	int count = 0;
+	char *copy = strdup(list);
+
+	for (char *token = strtok(copy, ","); token != NULL && count < SIM_MAX_SIZES; token = strtok(NULL, ","))
+	{
+		int size = atoi(token);
+		if (size <= 0)
+		{
+			free(copy);
+			return 0;
+		}
+		sizes[count++] = size;
+	}
+	free(copy);
+	return count;
+}
+
+static void
+usage (const char *program)
+{
+	fprintf(stderr, "usage: %s <trace> [--sizes n,n,...] [--k K]\n  K is at most %d; strategies marked * are simulation only\n",
+			program, BM_LRU_K_MAX);
+}
+
+int
+main (int argc, char **argv)
+{
+	const char *traceFile = NULL;
+	int sizes[SIM_MAX_SIZES];
+	int numSizes = 0;
+	int k = BM_LRU_K_DEFAULT;
+	SimTrace trace;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc)
+		{
+			if ((numSizes = parseSizes(argv[++i], sizes)) == 0)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc)
+			k = atoi(argv[++i]);
+		else if (traceFile == NULL && argv[i][0] != '-')
+			traceFile = argv[i];
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (traceFile == NULL || k <= 0 || k > BM_LRU_K_MAX)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	RC rc = loadTrace(traceFile, &trace);
+	if (rc != RC_OK)
+	{
+		fprintf(stderr, "policy_sim: cannot read trace %s (rc %d)\n", traceFile, rc);
+		return 1;
+	}
+	if (numSizes == 0)
+	{
+		for (int size = 1; numSizes < SIM_MAX_SIZES; size *= 2)
+		{
+			sizes[numSizes++] = size;
+			if (size >= trace.numPages)
+				break;
+		}
+	}
+
+	printf("trace %s: %ld events, %ld pins, %d distinct pages, LRU-K with k=%d\n\n",
+			traceFile, trace.numEvents, trace.numPins, trace.numPages, k);
+
+	SimResult results[SIM_MAX_SIZES][RS_NUM_STRATEGIES];
+	for (int s = 0; s < numSizes; s++)
+		for (int strategy = 0; strategy < RS_NUM_STRATEGIES; strategy++)
+			if (simulate(&trace, (ReplacementStrategy) strategy, sizes[s], k, &results[s][strategy]) != RC_OK)
+			{
+				fprintf(stderr, "policy_sim: out of memory\n");
+				return 1;
+			}
+
+	printf("hit ratio\n%8s", "frames");
+	for (int strategy = 0; strategy < RS_NUM_STRATEGIES; strategy++)
+		printf(" %8s", strategyNames[strategy]);
+	printf("\n");
+	for (int s = 0; s < numSizes; s++)
+	{
+		printf("%8d", sizes[s]);
+		for (int strategy = 0; strategy < RS_NUM_STRATEGIES; strategy++)
+		{
+			SimResult *result = &results[s][strategy];
+			long pins = result->hits + result->misses;
+			printf(" %8.4f", pins > 0 ? (double) result->hits / pins : 0.0);
+		}
+		printf("\n");
+	}
+
+	printf("* simulation only, pinPage does not implement this strategy\n");
+
+	printf("\nwrite-backs (failed pins)\n%8s", "frames");
+	for (int strategy = 0; strategy < RS_NUM_STRATEGIES; strategy++)
+		printf(" %14s", strategyNames[strategy]);
+	printf("\n");
+	for (int s = 0; s < numSizes; s++)
+	{
+		printf("%8d", sizes[s]);
+		for (int strategy = 0; strategy < RS_NUM_STRATEGIES; strategy++)
+			printf(" %7ld (%4ld)", results[s][strategy].writebacks, results[s][strategy].failures);
+		printf("\n");
+	}
+
+	free(trace.pages);
+	free(trace.kinds);
+	free(trace.dirty);
+	return 0;
+}
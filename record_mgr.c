@@ -3,10 +3,203 @@
 #include "stdlib.h"
 #include <string.h>
 #include "record_mgr.h"
+#include "latency.h"
+#include "metrics.h"
 
 
 int maximum_Pages = 5;
 
+// Blocks bulkLoadTable builds in memory and writes with one call
+#define LOAD_CHUNK_BLOCKS 4096
+
+// Pages vacuumTable compacts or drains per vacuumStep
+#define VACUUM_STEP_PAGES 64
+
+/*
+ * File layout: block 0 holds the schema. Every page directory page is
+ * followed by the PAGE_DIRECTORY_ENTRIES data pages it describes, so the
+ * directory pages sit at blocks 1, 2 + PAGE_DIRECTORY_ENTRIES, ... and a data
+ * page keeps its block when the directory grows.
+ */
+static inline int directoryPageBlock(int directoryPage) {
+    return 1 + directoryPage * (PAGE_DIRECTORY_ENTRIES + 1);
+}
+
+static inline int dataPageBlock(int page) {
+    return directoryPageBlock(page / PAGE_DIRECTORY_ENTRIES) + 1 + page % PAGE_DIRECTORY_ENTRIES;
+}
+
+// Number of data pages, numPages also counting the directory pages after the first
+static inline int numDataPages(RM_managementData *managementData) {
+    return managementData->numPages - managementData->numPageDP + 1;
+}
+
+/*
+ * Copies the directory entry of a data page into its directory page in the
+ * buffer pool. The page is only marked dirty; it reaches the disk when the
+ * pool writes it back, at the latest on checkpointTable or closeTable.
+ */
+static RC writeDirectoryEntry(RM_managementData *managementData, int page) {
+    BM_PageHandle directory;
+    memset(&directory, 0, sizeof(directory));
+
+    RC rc = pinPage(&managementData->bm, &directory, directoryPageBlock(page / PAGE_DIRECTORY_ENTRIES));
+    if (rc != RC_OK) {
+        return rc;
+    }
+    memcpy(directory.data + PAGE_DIRECTORY_HEADER_SIZE + (page % PAGE_DIRECTORY_ENTRIES) * sizeof(PageDirectoryEntry),
+           &managementData->pageDirectory[page], sizeof(PageDirectoryEntry));
+    markDirty(&managementData->bm, &directory);
+    return unpinPage(&managementData->bm, &directory);
+}
+
+// Same as writeDirectoryEntry for the page counts in the first directory page
+static RC writeDirectoryHeader(RM_managementData *managementData) {
+    BM_PageHandle directory;
+    memset(&directory, 0, sizeof(directory));
+
+    RC rc = pinPage(&managementData->bm, &directory, directoryPageBlock(0));
+    if (rc != RC_OK) {
+        return rc;
+    }
+    memcpy(directory.data, &managementData->numPages, sizeof(int));
+    memcpy(directory.data + sizeof(int), &managementData->numPageDP, sizeof(int));
+    markDirty(&managementData->bm, &directory);
+    return unpinPage(&managementData->bm, &directory);
+}
+
+/*
+ * Computes the record layout of a schema once, so attribute accesses are a
+ * single lookup: the offset of every attribute in Record.data (after the null
+ * bitmap), the record size, and whether records are stored as Record.data.
+ *
+ * Returns:
+ * - RC_OK on success, RC_RM_DATA_TYPE_ERROR for an unknown data type,
+ *   RC_MEMORY_ALLOCATION_FAIL if the offsets cannot be allocated.
+ */
+static RC initSchemaLayout(Schema *schema) {
+    schema->attrOffsets = (int *)malloc((schema->numAttr + 1) * sizeof(int));
+    if (schema->attrOffsets == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    int offset = NULL_BITMAP_SIZE(schema->numAttr);
+    schema->fixedSize = true;
+    for (int i = 0; i < schema->numAttr; i++) {
+        schema->attrOffsets[i] = offset;
+        switch (schema->dataTypes[i]) {
+            case DT_INT:
+                offset += sizeof(int);
+                break;
+            case DT_FLOAT:
+                offset += sizeof(float);
+                break;
+            case DT_BOOL:
+                offset += sizeof(bool);
+                break;
+            case DT_VARCHAR:
+                schema->fixedSize = false;
+                offset += schema->typeLength[i];
+                break;
+            case DT_STRING:
+                offset += schema->typeLength[i];
+                break;
+            default:
+                free(schema->attrOffsets);
+                schema->attrOffsets = NULL;
+                return RC_RM_DATA_TYPE_ERROR;
+        }
+    }
+    schema->attrOffsets[schema->numAttr] = offset;
+    return RC_OK;
+}
+
+// Size of an attribute in Record.data
+static inline int attrSize(Schema *schema, int attrNum) {
+    return schema->attrOffsets[attrNum + 1] - schema->attrOffsets[attrNum];
+}
+
+// Number of attributes up to the last one that is not NULL
+static int storedAttrs(Schema *schema, const char *data) {
+    int n = schema->numAttr;
+    while (n > 0 && (data[(n - 1) / 8] & (1 << ((n - 1) % 8)))) {
+        n--;
+    }
+    return n;
+}
+
+/*
+ * Returns the bytes a record is stored as and sets *length. The NULL
+ * attributes at the end of a record are left out. Records without DT_VARCHAR
+ * attributes are otherwise stored as they are; records with them are packed
+ * into packed, every varchar as a length byte followed by its characters.
+ */
+static const char *storedRecord(Schema *schema, const char *data, char *packed, int *length) {
+    int numStored = storedAttrs(schema, data);
+    if (schema->fixedSize) {
+        *length = schema->attrOffsets[numStored];
+        return data;
+    }
+
+    int in = NULL_BITMAP_SIZE(schema->numAttr), out = in;
+    memcpy(packed, data, in);
+    for (int i = 0; i < numStored; i++) {
+        int size = attrSize(schema, i);
+        if (schema->dataTypes[i] == DT_VARCHAR) {
+            int chars = strnlen(data + in, size);
+            packed[out++] = (char) chars;
+            memcpy(packed + out, data + in, chars);
+            out += chars;
+        } else {
+            memcpy(packed + out, data + in, size);
+            out += size;
+        }
+        in += size;
+    }
+    *length = out;
+    return packed;
+}
+
+// Largest number of bytes a record of the schema is stored as
+static int maxStoredSize(Schema *schema) {
+    int size = getRecordSize(schema);
+    for (int i = 0; i < schema->numAttr; i++) {
+        if (schema->dataTypes[i] == DT_VARCHAR) {
+            size++;
+        }
+    }
+    return size;
+}
+
+// Copies the record of a used slot into Record.data, unpacking varchars and
+// zeroing the NULL attributes that were not stored
+static void readStoredRecord(Schema *schema, SM_PageHandle pageHandle, SlotDirectoryEntry *slotEntry, char *data) {
+    const char *stored = pageHandle + slotEntry->offset;
+    if (schema->fixedSize) {
+        memcpy(data, stored, slotEntry->length);
+        memset(data + slotEntry->length, 0, getRecordSize(schema) - slotEntry->length);
+        return;
+    }
+
+    int in = NULL_BITMAP_SIZE(schema->numAttr), out = in;
+    memcpy(data, stored, in);
+    for (int i = 0; i < schema->numAttr; i++) {
+        int size = attrSize(schema, i);
+        if (in >= slotEntry->length) {
+            memset(data + out, 0, size);
+        } else if (schema->dataTypes[i] == DT_VARCHAR) {
+            int chars = (unsigned char) stored[in++];
+            memcpy(data + out, stored + in, chars);
+            memset(data + out + chars, 0, size - chars);
+            in += chars;
+        } else {
+            memcpy(data + out, stored + in, size);
+            in += size;
+        }
+        out += size;
+    }
+}
+
 /*
  * Initializes the Record Manager module.
  * This function initializes the Record Manager module by calling the `initStorageManager` function,
@@ -56,6 +249,16 @@ extern RC createTable(char *name, Schema *schema) {
         return RC_INVALID_INPUT;
     }
 
+    // A varchar's length must fit its length byte, and every record a page
+    for (int i = 0; i < schema->numAttr; i++) {
+        if (schema->dataTypes[i] == DT_VARCHAR && schema->typeLength[i] > VARCHAR_MAX_LENGTH) {
+            return RC_RM_STRING_TOO_LONG;
+        }
+    }
+    if (maxStoredSize(schema) + (int) sizeof(SlotDirectoryEntry) > PAGE_SIZE) {
+        return RC_RM_INVALID_RECORD_SIZE;
+    }
+
     // Create the underlying page file, with error handling
     RC createFileRC = createPageFile(name);
     if (createFileRC != RC_OK) {
@@ -222,7 +425,38 @@ writeRC = writeBlock(1, &fileHandle, pageHandle);
 
 
 
+/*
+ * Opens an existing table with the default buffer pool size.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure to be filled in.
+ * - name: The name of the table to open.
+ *
+ * Returns:
+ * - RC_OK: The table was opened successfully.
+ */
 extern RC openTable(RM_TableData *rel, char *name) {
+    return openTableWithPoolSize(rel, name, maximum_Pages);
+}
+
+/*
+ * Opens an existing table backed by a buffer pool of the given number of frames.
+ * Hot tables can be given a larger pool here, or later through resizeTablePool.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure to be filled in.
+ * - name: The name of the table to open.
+ * - poolSize: Number of page frames in the table's buffer pool.
+ *
+ * Returns:
+ * - RC_OK: The table was opened successfully.
+ * - RC_INVALID_INPUT: The pool size is not positive.
+ */
+extern RC openTableWithPoolSize(RM_TableData *rel, char *name, int poolSize) {
+    if (poolSize <= 0) {
+        return RC_INVALID_INPUT;
+    }
+
     // Allocate memory for RM_TableData structure
     rel->name = name;
     rel->schema = (Schema *)calloc(1, sizeof(Schema));  // Using calloc for zero-initialization
@@ -244,7 +478,7 @@ switch (rc = openPageFile(name, &managementData->fileHndl)) {
 }
 
 // Initialize the buffer pool with LRU replacement strategy
-rc = initBufferPool(&managementData->bm, name, maximum_Pages, RS_LRU, NULL);
+rc = initBufferPool(&managementData->bm, name, poolSize, RS_LRU, NULL);
 if (rc != RC_OK) {
     return rc;  // Early exit if buffer pool setup fails
 }
@@ -306,6 +540,12 @@ rel->schema->keyAttrs = (int *)malloc(keyAttrSize);
 memcpy(rel->schema->keyAttrs, pageData + offset, keyAttrSize);
 offset += keyAttrSize; // Adjust offset for key attributes
 
+// Lay out the attributes of the table's records
+rc = initSchemaLayout(rel->schema);
+if (rc != RC_OK) {
+    return rc;
+}
+
 // Clean up previous memory
 if (managementData->memPageSM) {
     free(managementData->memPageSM); // Free memory if not null
@@ -335,11 +575,26 @@ managementData->numPages = pageInfo[0];
 managementData->numPageDP = pageInfo[1];
 
 
-// Allocate memory for the page directory and copy the data
-int numEntries = managementData->numPages - managementData->numPageDP + 1;
+// Allocate memory for the page directory and copy the entries of every directory page
+int numEntries = numDataPages(managementData);
 int pageDirSize = numEntries * sizeof(PageDirectoryEntry);
 managementData->pageDirectory = (PageDirectoryEntry *)malloc(pageDirSize);
-memcpy(managementData->pageDirectory, managementData->memPageSM + 2 * sizeof(int), pageDirSize);
+for (int i = 0; i < numEntries; i += PAGE_DIRECTORY_ENTRIES) {
+    int count = numEntries - i < PAGE_DIRECTORY_ENTRIES ? numEntries - i : PAGE_DIRECTORY_ENTRIES;
+    rc = pinPage(&managementData->bm, &managementData->pageHndlBM, directoryPageBlock(i / PAGE_DIRECTORY_ENTRIES));
+    if (rc != RC_OK) {
+        return rc;
+    }
+    memcpy(&managementData->pageDirectory[i], managementData->pageHndlBM.data + PAGE_DIRECTORY_HEADER_SIZE,
+           count * sizeof(PageDirectoryEntry));
+    unpinPage(&managementData->bm, &managementData->pageHndlBM);
+}
+
+// Bucket the data pages by their free space
+fsmInit(&managementData->freeSpace);
+for (int i = 0; i < numEntries; i++) {
+    fsmSetFreeSpace(&managementData->freeSpace, i, managementData->pageDirectory[i].freeSpace);
+}
 
 // Free the memory used by the in-memory page
 free(managementData->memPageSM);
@@ -350,6 +605,49 @@ managementData->memPageSM = NULL; // Set the pointer to NULL after freeing
 }
 
 
+/*
+ * Resizes the buffer pool of an open table without closing it.
+ * Shrinking evicts unpinned pages, writing back the dirty ones first.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ * - poolSize: New number of page frames in the table's buffer pool.
+ *
+ * Returns:
+ * - RC_OK: The buffer pool was resized successfully.
+ * - RC_RM_NULL_POINTER: The table is not open.
+ */
+extern RC resizeTablePool(RM_TableData *rel, int poolSize) {
+    if (rel == NULL || rel->managementData == NULL) {
+        return RC_RM_NULL_POINTER;
+    }
+
+    RM_managementData *managementData = (RM_managementData *)rel->managementData;
+    return resizeBufferPool(&managementData->bm, poolSize);
+}
+
+
+/*
+ * Writes every modified page of an open table to disk, including the page
+ * directory, which inserts and deletes only update in the buffer pool.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ *
+ * Returns:
+ * - RC_OK: All dirty pages were written.
+ * - RC_RM_NULL_POINTER: The table is not open.
+ */
+extern RC checkpointTable(RM_TableData *rel) {
+    if (rel == NULL || rel->managementData == NULL) {
+        return RC_RM_NULL_POINTER;
+    }
+
+    RM_managementData *managementData = (RM_managementData *)rel->managementData;
+    return forceFlushPool(&managementData->bm);
+}
+
+
 /*
  * Closes the specified table.
  * This function closes the specified table, frees memory allocated for schema information,
@@ -368,6 +666,9 @@ extern RC closeTable(RM_TableData *rel) {
 
     RM_managementData *managementData = (RM_managementData *)rel->managementData;
 
+    // Stop metrics snapshots from reading the table before it is freed
+    metricsForgetTable(rel);
+
     // Free the schema information
     if (rel->schema->attrNames != NULL) {
     int i = 0; // Initialize the index variable
@@ -386,6 +687,7 @@ free(rel->schema->typeLength);
 
 
 free(rel->schema->keyAttrs);
+free(rel->schema->attrOffsets);
 free(rel->schema);
 
 
@@ -393,6 +695,7 @@ free(rel->schema);
     if (managementData->pageDirectory != NULL) {
         free(managementData->pageDirectory);
     }
+    fsmFree(&managementData->freeSpace);
 
     // Shutdown the buffer pool
     RC rc = shutdownBufferPool(&managementData->bm);
@@ -434,6 +737,9 @@ extern RC deleteTable(char *name) {
         return rc; // Return the error code if the deletion fails
     }
 
+    // A warm-restart snapshot of the old file must not outlive it
+    discardResidencySnapshot(name);
+
     return RC_OK; // Return success if the deletion was successful
 }
 
@@ -466,7 +772,7 @@ extern int getNumTuples(RM_TableData *rel) {
 
     // Traverse each page in the directory and count the tuples
    int pageIdx = 0; // Initialize the page index
-while (pageIdx < managementData->numPages) {
+while (pageIdx < numDataPages(managementData)) {
     PageDirectoryEntry *currentEntry = &managementData->pageDirectory[pageIdx];
     totalTuples += currentEntry->recordCount; // Add record count from current page
     pageIdx++; // Increment the page index
@@ -475,163 +781,455 @@ while (pageIdx < managementData->numPages) {
 }
 
 
-extern RC insertRecord (RM_TableData *rel, Record *record){
-RM_managementData *managementData = (RM_managementData *)rel->managementData;
-
-// Define constants for maximum page directory entries and record size
-int recordSize = getRecordSize(rel->schema); int maxEntriesInPD = (PAGE_SIZE - 2 * sizeof(int)) / sizeof(PageDirectoryEntry);
-
-
-// Determine if a new page directory is required
-bool needsNewPageDirectory = managementData->numPages > maxEntriesInPD * managementData->numPageDP;
+/*
+ * Appends a new, empty data page to the table: a directory entry, its class
+ * in the free-space map and, every PAGE_DIRECTORY_ENTRIES pages, a new
+ * directory page. The pages themselves are created by the buffer pool on
+ * their first pin.
+ */
+static RC addDataPage(RM_managementData *managementData, int *pageNum) {
+    int page = numDataPages(managementData);
+
+    // Resize the page directory to accommodate the new page; a metrics
+    // snapshot may be reading the old one
+    metricsLockSources();
+    PageDirectoryEntry *pageDirectory = (PageDirectoryEntry *) realloc(managementData->pageDirectory,
+                                                                      (page + 1) * sizeof(PageDirectoryEntry));
+    if (pageDirectory == NULL) {
+        metricsUnlockSources();
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    managementData->pageDirectory = pageDirectory;
 
-if (needsNewPageDirectory) {
-    // Increment the page and directory counts
+    // A page starting a new group of data pages also starts a new directory page
+    if (page % PAGE_DIRECTORY_ENTRIES == 0) {
+        managementData->numPages++;
+        managementData->numPageDP++;
+    }
     managementData->numPages++;
-    managementData->numPageDP++;
+    metricsUnlockSources();
 
-    // Allocate and initialize memory for the new page directory
-    PageDirectoryEntry *newPageDirectory = (PageDirectoryEntry *)malloc(PAGE_SIZE);
-    if (newPageDirectory) {
-        memset(newPageDirectory, 0, PAGE_SIZE);
-
-        // Create a handle for the new page directory to be written to disk
-        SM_PageHandle pageDirectoryHandle = (SM_PageHandle)malloc(PAGE_SIZE);
-        if (pageDirectoryHandle) {
-            memcpy(pageDirectoryHandle, newPageDirectory, PAGE_SIZE);
-            memset(pageDirectoryHandle + sizeof(PageDirectoryEntry), 0, PAGE_SIZE - sizeof(PageDirectoryEntry));
-
-            // Write the new page directory to the specified block
-            writeBlock(managementData->numPages + 1, &managementData->fileHndl, pageDirectoryHandle);
+    managementData->pageDirectory[page] = (PageDirectoryEntry){
+        .pageID = page,
+        .hasFreeSlot = true,
+        .freeSpace = PAGE_SIZE,
+        .recordCount = 0
+    };
+    *pageNum = page;
+    return fsmSetFreeSpace(&managementData->freeSpace, page, PAGE_SIZE);
+}
 
-            // Clean up allocated memory for the handle
-            free(pageDirectoryHandle);
+// Lowest offset of a record on the page; free bytes lie between the slots and it
+static int recordsStart(SM_PageHandle pageHandle, int numSlots) {
+    int start = PAGE_SIZE;
+    for (int z = 0; z < numSlots; z++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + z * sizeof(SlotDirectoryEntry));
+        if (!slotEntry->isFree && slotEntry->offset < start) {
+            start = slotEntry->offset;
         }
-        // Free the allocated memory for the new page directory
-        free(newPageDirectory);
     }
+    return start;
 }
 
-// Initialize page number to an invalid state
-int i = 0; // Initialize the index
-int pageNum = -1; // Initialize pageNum to -1
+/*
+ * Moves the records of a page against its end, in offset order, so the holes
+ * left by deleted, shrunk and moved records become one free area after the
+ * slots. Slot numbers, and so RIDs, do not change.
+ */
+static void compactPage(SM_PageHandle pageHandle, int numSlots) {
+    int order[PAGE_SIZE / sizeof(SlotDirectoryEntry)];
+    int used = 0;
+
+    // Used slots by decreasing offset
+    for (int z = 0; z < numSlots; z++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + z * sizeof(SlotDirectoryEntry));
+        if (slotEntry->isFree) {
+            continue;
+        }
+        int k = used++;
+        while (k > 0 && ((SlotDirectoryEntry *)(pageHandle + order[k - 1] * sizeof(SlotDirectoryEntry)))->offset
+                        < slotEntry->offset) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = z;
+    }
 
-// Find a page with free space using a while loop
-while (i <= managementData->numPages - managementData->numPageDP) {
-    if (managementData->pageDirectory[i].hasFreeSlot) {
-        pageNum = i; // Found a page with free space
-        break; // Exit the loop
+    // Records only move up, so moving the highest first never overwrites one not yet moved
+    int end = PAGE_SIZE;
+    for (int k = 0; k < used; k++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + order[k] * sizeof(SlotDirectoryEntry));
+        end -= slotEntry->length;
+        memmove(pageHandle + end, pageHandle + slotEntry->offset, slotEntry->length);
+        slotEntry->offset = end;
     }
-    i++; // Increment the index to check the next page
 }
 
+/*
+ * Finds room for length bytes below the records of a page whose slot array
+ * ends at slotsEnd, compacting the page if its free bytes are fragmented.
+ * The caller checks that the page has that many free bytes.
+ *
+ * Returns the offset for the bytes.
+ */
+static int allocateOnPage(SM_PageHandle pageHandle, int numSlots, int slotsEnd, int length) {
+    int start = recordsStart(pageHandle, numSlots);
+    if (start - slotsEnd < length) {
+        compactPage(pageHandle, numSlots);
+        start = recordsStart(pageHandle, numSlots);
+    }
+    return start - length;
+}
 
-    // Check if a free page was found; if not, allocate a new page
-if (pageNum == -1) {
-    // Calculate the new page number and update management data
-    pageNum = managementData->numPages + 1 - managementData->numPageDP;
-    managementData->numPages++;
-
-    // Resize the page directory to accommodate the new page
-    int newPageDirSize = (managementData->numPages - managementData->numPageDP + 1) * sizeof(PageDirectoryEntry);
-    managementData->pageDirectory = (PageDirectoryEntry*) realloc(managementData->pageDirectory, newPageDirSize);
-    
-    // Initialize the new page directory entry
-    managementData->pageDirectory[pageNum] = (PageDirectoryEntry){
-        .pageID = managementData->numPages - managementData->numPageDP,
-        .hasFreeSlot = true,
-        .freeSpace = PAGE_SIZE,
-        .recordCount = 0
-    };
-
-    // Allocate and initialize a new page
-    SM_PageHandle newPageHandle = (SM_PageHandle)malloc(PAGE_SIZE);
-    memset(newPageHandle, 0, PAGE_SIZE);
+/*
+ * Stores one record, in its stored form, on a pinned data page and accounts
+ * it in the page's directory entry. The first free slot at or after
+ * *slotCursor is reused, otherwise a new slot is appended; the cursor moves
+ * past the slot taken so consecutive calls on one page never rescan the
+ * slots already filled. The caller checks that the entry has room for the
+ * record and a slot.
+ *
+ * Returns the slot number of the record.
+ */
+static int placeRecord(SM_PageHandle pageHandle, PageDirectoryEntry *entry, const char *stored, int length,
+                       int *slotCursor) {
+    int slotNum = -1;
+    for (int z = *slotCursor; z < entry->recordCount; z++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + z * sizeof(SlotDirectoryEntry));
+        if (slotEntry->isFree) {
+            slotNum = z;
+            break;
+        }
+    }
 
-    // Write the new page to disk
-    writeBlock(managementData->numPages + 1, &managementData->fileHndl, newPageHandle);
-    free(newPageHandle);
+    // If no free slot is found, append one
+    bool reusedSlot = slotNum != -1;
+    int numSlots = reusedSlot ? entry->recordCount : entry->recordCount + 1;
+    if (!reusedSlot) {
+        slotNum = entry->recordCount;
+    }
+    *slotCursor = slotNum + 1;
+
+    // Records are packed down from the end of the page
+    int recordOffset = allocateOnPage(pageHandle, entry->recordCount, numSlots * sizeof(SlotDirectoryEntry), length);
+    entry->recordCount = numSlots;
+    SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + slotNum * sizeof(SlotDirectoryEntry));
+    slotEntry->offset = recordOffset;
+    slotEntry->length = length;
+    slotEntry->isFree = false;
+    memcpy(pageHandle + recordOffset, stored, length);
+
+    // Adjust free space and slot availability; a reused slot already has its entry
+    entry->freeSpace -= length + (reusedSlot ? 0 : sizeof(SlotDirectoryEntry));
+    entry->hasFreeSlot = entry->freeSpace >= (int) (length + sizeof(SlotDirectoryEntry));
+    return slotNum;
 }
 
-// Pin the newly allocated page to read from it
-pinPage(&managementData->bm, &managementData->pageHndlBM, managementData->numPages + 1);
-SM_PageHandle pageHandle = managementData->pageHndlBM.data;
+/*
+ * Inserts a record into the table and sets its RID.
+ * The page comes from the free-space map, or is appended when no page has
+ * room. The data page and the page directory are only changed in the buffer
+ * pool, so an insert does no I/O unless the pool has to evict a dirty page.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ * - record: The record to insert; its id is set to the new RID.
+ *
+ * Returns:
+ * - RC_OK: The record was inserted successfully.
+ */
+extern RC insertRecord (RM_TableData *rel, Record *record){
+    RM_managementData *managementData = (RM_managementData *)rel->managementData;
+    LATENCY_START(start);
+
+    char packed[PAGE_SIZE];
+    int length;
+    int slotCursor = 0;
+    RC rc;
+
+    // Ask the free-space map for a page with room for the stored record and a new slot
+    const char *stored = storedRecord(rel->schema, record->data, packed, &length);
+    int pageNum = fsmFindPage(&managementData->freeSpace, length + sizeof(SlotDirectoryEntry));
+    bool newPage = pageNum == FSM_NO_PAGE;
+    if (newPage && (rc = addDataPage(managementData, &pageNum)) != RC_OK) {
+        return rc;
+    }
 
-// Locate a free slot within the page
-int slotNum = -1; // Initialize slotNum to -1 to indicate no free slot found
-int z = 0; // Initialize the loop variable
+    // Pin the chosen page and store the record on it
+    rc = pinPage(&managementData->bm, &managementData->pageHndlBM, dataPageBlock(pageNum));
+    if (rc != RC_OK) {
+        return rc;
+    }
+    PageDirectoryEntry *entry = &managementData->pageDirectory[pageNum];
+    record->id.page = pageNum;
+    record->id.slot = placeRecord(managementData->pageHndlBM.data, entry, stored, length, &slotCursor);
+    fsmSetFreeSpace(&managementData->freeSpace, pageNum, entry->freeSpace);
 
-// Loop through the slot entries until a free slot is found or all entries are checked
-while (z <= managementData->pageDirectory[pageNum].recordCount) {
-    SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + z * sizeof(SlotDirectoryEntry));
-    if (slotEntry->isFree) {
-        slotNum = z; // Found a free slot
-        break; // Exit the loop
+    // The pool writes the page back on eviction, checkpoint or close
+    markDirty(&managementData->bm, &managementData->pageHndlBM);
+    unpinPage(&managementData->bm, &managementData->pageHndlBM);
+
+    // Record the page's new state in the buffered directory, and the page count if it grew
+    rc = writeDirectoryEntry(managementData, pageNum);
+    if (rc == RC_OK && newPage) {
+        rc = writeDirectoryHeader(managementData);
     }
-    z++; // Increment the loop variable
+    if (rc != RC_OK) {
+        return rc;
+    }
+
+    LATENCY_RECORD(LAT_INSERT_RECORD, start);
+    return RC_OK;
 }
 
+/*
+ * Inserts n records and sets their RIDs, which are assigned in array order.
+ * Pages are filled one after the other: each page is pinned once, receives
+ * as many records as fit, and has its directory entry and free-space class
+ * updated once before the next page is taken.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ * - records: Array of n records to insert; their ids are set to the new RIDs.
+ * - n: Number of records.
+ *
+ * Returns:
+ * - RC_OK: All records were inserted.
+ * - RC_RM_NULL_POINTER: The table is not open or records is NULL.
+ * - Any error of the buffer pool; records before the failing page keep their RIDs.
+ */
+extern RC insertRecords(RM_TableData *rel, Record **records, int n) {
+    if (rel == NULL || rel->managementData == NULL || records == NULL || n < 0) {
+        return RC_RM_NULL_POINTER;
+    }
 
-// If no free slot is found, append the record at the end
-// Determine the slot number for the new record
-if (slotNum == -1) {
-    slotNum = managementData->pageDirectory[pageNum].recordCount++;
-}
+    RM_managementData *managementData = (RM_managementData *)rel->managementData;
+    char packed[PAGE_SIZE];
+    int length;
+    bool pagesAdded = false;
+    RC rc = RC_OK;
+
+    for (int i = 0; i < n && rc == RC_OK; ) {
+        const char *stored = storedRecord(rel->schema, records[i]->data, packed, &length);
+        int pageNum = fsmFindPage(&managementData->freeSpace, length + sizeof(SlotDirectoryEntry));
+        if (pageNum == FSM_NO_PAGE) {
+            if ((rc = addDataPage(managementData, &pageNum)) != RC_OK) {
+                break;
+            }
+            pagesAdded = true;
+        }
 
-// Calculate the offset for the new record based on the current record count
-int recordOffset = PAGE_SIZE - (managementData->pageDirectory[pageNum].recordCount * recordSize);
+        rc = pinPage(&managementData->bm, &managementData->pageHndlBM, dataPageBlock(pageNum));
+        if (rc != RC_OK) {
+            break;
+        }
 
-// Access the slot directory entry for the new record
-SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(pageHandle + slotNum * sizeof(SlotDirectoryEntry));
-slotEntry->offset = recordOffset;   // Set the offset for the new record
-slotEntry->isFree = false;           // Mark the slot as occupied
+        // Fill the page
+        PageDirectoryEntry *entry = &managementData->pageDirectory[pageNum];
+        int slotCursor = 0;
+        while (entry->freeSpace >= (int) (length + sizeof(SlotDirectoryEntry))) {
+            records[i]->id.page = pageNum;
+            records[i]->id.slot = placeRecord(managementData->pageHndlBM.data, entry, stored, length, &slotCursor);
+            if (++i == n) {
+                break;
+            }
+            stored = storedRecord(rel->schema, records[i]->data, packed, &length);
+        }
+        fsmSetFreeSpace(&managementData->freeSpace, pageNum, entry->freeSpace);
 
-// Copy the record data into the designated location in the page
-memcpy((char *)pageHandle + recordOffset, record->data, recordSize);
+        markDirty(&managementData->bm, &managementData->pageHndlBM);
+        unpinPage(&managementData->bm, &managementData->pageHndlBM);
+        rc = writeDirectoryEntry(managementData, pageNum);
+    }
 
-// Update the record ID to reflect the new location in the page and slot
-record->id.page = managementData->pageDirectory[pageNum].pageID;
-record->id.slot = slotNum;
+    if (pagesAdded) {
+        RC headerRC = writeDirectoryHeader(managementData);
+        if (rc == RC_OK) {
+            rc = headerRC;
+        }
+    }
+    return rc;
+}
 
+/*
+ * Writes the blocks built by bulkLoadTable from startBlock on with one vectored
+ * write, then counts the data pages they add in the directory header fields.
+ */
+static RC flushLoadChunk(RM_managementData *managementData, char *chunk, int startBlock, int numBlocks,
+                         int dataPages) {
+    SM_PageHandle blocks[LOAD_CHUNK_BLOCKS];
+    for (int i = 0; i < numBlocks; i++) {
+        blocks[i] = chunk + i * PAGE_SIZE;
+    }
 
-// Adjust free space and slot availability in the page directory entry
-managementData->pageDirectory[pageNum].freeSpace -= (recordSize + sizeof(SlotDirectoryEntry));
-// Check if there is enough free space on the page to accommodate the new record and its slot entry
-bool isSpaceAvailable = managementData->pageDirectory[pageNum].freeSpace >= (recordSize + sizeof(SlotDirectoryEntry));
-managementData->pageDirectory[pageNum].hasFreeSlot = isSpaceAvailable ? true : false;
+    RC rc = ensureCapacity(startBlock, &managementData->fileHndl);
+    if (rc == RC_OK) {
+        rc = writeBlocks(startBlock, numBlocks, &managementData->fileHndl, blocks);
+    }
+    if (rc != RC_OK) {
+        return rc;
+    }
 
-// Perform page update operations
-markDirty(&managementData->bm, &managementData->pageHndlBM);
-unpinPage(&managementData->bm, &managementData->pageHndlBM);
+    if (dataPages > numDataPages(managementData)) {
+        managementData->numPageDP = (dataPages + PAGE_DIRECTORY_ENTRIES - 1) / PAGE_DIRECTORY_ENTRIES;
+        managementData->numPages = dataPages + managementData->numPageDP - 1;
+    }
+    return RC_OK;
+}
+
+/*
+ * Bulk loads the rows of a source into a closed table without going through
+ * the buffer pool. Fully packed data pages are built in private memory after
+ * the last page holding records and written LOAD_CHUNK_BLOCKS blocks at a
+ * time with one sequential write. The directory page of every new group of
+ * data pages is built alongside its pages and written in the same run; only
+ * the entries of the table's last existing group and the page counts go
+ * through the buffer pool, once, when the table is closed at the end.
+ *
+ * Parameters:
+ * - name: The name of the table; it must exist and must not be open.
+ * - source: Fills a getRecordSize buffer with the next row; returns
+ *   RC_RM_NO_MORE_TUPLES after the last row.
+ * - context: Passed to source.
+ * - rowsLoaded: Set to the number of rows stored. May be NULL.
+ *
+ * Returns:
+ * - RC_OK: Every row of the source was stored.
+ * - An error of the source: the rows before the failing one are stored.
+ * - Any error of opening the table or of the writes.
+ */
+extern RC bulkLoadTable(char *name, RM_RowSource source, void *context, long *rowsLoaded) {
+    RM_TableData rel;
 
-// Write the modified page back to the file
-int pageToWrite = managementData->numPages + 1;
-writeBlock(pageToWrite, &managementData->fileHndl, pageHandle);
+    if (rowsLoaded != NULL) {
+        *rowsLoaded = 0;
+    }
+    if (name == NULL || source == NULL) {
+        return RC_RM_NULL_POINTER;
+    }
 
-// Prepare to update the page directory
-SM_PageHandle pageDirectoryHandle = (SM_PageHandle)malloc(PAGE_SIZE);
+    RC rc = openTable(&rel, name);
+    if (rc != RC_OK) {
+        return rc;
+    }
+    RM_managementData *managementData = (RM_managementData *)rel.managementData;
+    int recordSize = getRecordSize(rel.schema);
+    char *chunk = (char *) malloc(LOAD_CHUNK_BLOCKS * PAGE_SIZE);
+    char *row = (char *) malloc(recordSize);
+    char packed[PAGE_SIZE];
+    const char *stored = NULL;
+    int length = 0;
+    if (chunk == NULL || row == NULL) {
+        free(chunk);
+        free(row);
+        closeTable(&rel);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
 
-// Initialize the page directory handle with zeros for safety
-memset(pageDirectoryHandle, 0, PAGE_SIZE);
+    // Empty pages at the end of the last group are filled too; the directory
+    // page of that group already exists and is updated through the pool
+    int existingPages = numDataPages(managementData);
+    int lastGroupStart = (existingPages - 1) / PAGE_DIRECTORY_ENTRIES * PAGE_DIRECTORY_ENTRIES;
+    int firstNewGroupPage = lastGroupStart + PAGE_DIRECTORY_ENTRIES;
+    int firstPage = existingPages;
+    while (firstPage > lastGroupStart && managementData->pageDirectory[firstPage - 1].recordCount == 0) {
+        firstPage--;
+    }
 
-// Store the number of pages and number of data pages in the page directory handle
-memcpy(pageDirectoryHandle, &managementData->numPages, sizeof(int));
-memcpy(pageDirectoryHandle + sizeof(int), &managementData->numPageDP, sizeof(int));
+    int page = firstPage;
+    int directoryCapacity = existingPages;
+    int startBlock = 0;
+    int numBlocks = 0;
+    char *directoryBlock = NULL;
+    long loaded = 0, storedRows = 0;
+    bool writeFailed = false;
 
-// Copy the modified page directory entries into the handle
-size_t offset = 2 * sizeof(int);
-memcpy(pageDirectoryHandle + offset, 
-       &managementData->pageDirectory[managementData->numPageDP - 1], 
-       PAGE_SIZE - offset);
+    if ((rc = source(context, rel.schema, row)) == RC_OK) {
+        stored = storedRecord(rel.schema, row, packed, &length);
+    }
+    while (rc == RC_OK) {
+        // A new group starts with its directory page and never spans two chunks
+        bool newGroup = page >= firstNewGroupPage && page % PAGE_DIRECTORY_ENTRIES == 0;
+        if (newGroup && numBlocks + PAGE_DIRECTORY_ENTRIES + 1 > LOAD_CHUNK_BLOCKS) {
+            if ((rc = flushLoadChunk(managementData, chunk, startBlock, numBlocks, page)) != RC_OK) {
+                writeFailed = true;
+                break;
+            }
+            storedRows = loaded;
+            numBlocks = 0;
+        }
+        if (page == directoryCapacity) {
+            directoryCapacity = directoryCapacity < 16 ? 16 : directoryCapacity * 2;
+            PageDirectoryEntry *pageDirectory = (PageDirectoryEntry *) realloc(managementData->pageDirectory,
+                                                                              directoryCapacity * sizeof(PageDirectoryEntry));
+            if (pageDirectory == NULL) {
+                rc = RC_MEMORY_ALLOCATION_FAIL;
+                break;
+            }
+            managementData->pageDirectory = pageDirectory;
+        }
+        if (numBlocks == 0) {
+            startBlock = newGroup ? directoryPageBlock(page / PAGE_DIRECTORY_ENTRIES) : dataPageBlock(page);
+        }
+        if (newGroup) {
+            directoryBlock = chunk + numBlocks++ * PAGE_SIZE;
+            memset(directoryBlock, 0, PAGE_SIZE);
+        }
 
-// Calculate the appropriate block for writing the page directory
-int blockToWrite = (managementData->numPages / maxEntriesInPD) * maxEntriesInPD + managementData->numPageDP;
-writeBlock(blockToWrite, &managementData->fileHndl, pageDirectoryHandle);
+        // Pack the page with rows
+        SM_PageHandle pageHandle = chunk + numBlocks++ * PAGE_SIZE;
+        memset(pageHandle, 0, PAGE_SIZE);
+        PageDirectoryEntry *entry = &managementData->pageDirectory[page];
+        *entry = (PageDirectoryEntry){
+            .pageID = page,
+            .hasFreeSlot = true,
+            .freeSpace = PAGE_SIZE,
+            .recordCount = 0
+        };
+        int slotCursor = 0;
+        while (rc == RC_OK && entry->freeSpace >= (int) (length + sizeof(SlotDirectoryEntry))) {
+            placeRecord(pageHandle, entry, stored, length, &slotCursor);
+            loaded++;
+            if ((rc = source(context, rel.schema, row)) == RC_OK) {
+                stored = storedRecord(rel.schema, row, packed, &length);
+            }
+        }
+        fsmSetFreeSpace(&managementData->freeSpace, page, entry->freeSpace);
+        if (page >= firstNewGroupPage) {
+            memcpy(directoryBlock + PAGE_DIRECTORY_HEADER_SIZE + (page % PAGE_DIRECTORY_ENTRIES) * sizeof(PageDirectoryEntry),
+                   entry, sizeof(PageDirectoryEntry));
+        }
+        page++;
+    }
 
-// Free allocated memory for the page directory handle
-free(pageDirectoryHandle);
+    // Keep the rows read before a failing one unless writing them failed
+    RC loadRC = rc == RC_RM_NO_MORE_TUPLES ? RC_OK : rc;
+    rc = RC_OK;
+    if (!writeFailed && numBlocks > 0) {
+        rc = flushLoadChunk(managementData, chunk, startBlock, numBlocks, page);
+        writeFailed = rc != RC_OK;
+        storedRows = writeFailed ? storedRows : loaded;
+    }
+    free(chunk);
+    free(row);
 
-    return RC_OK;
+    // Directory entries that live in a directory page the table already had
+    int dataPages = numDataPages(managementData);
+    for (int p = firstPage; rc == RC_OK && p < dataPages && p < firstNewGroupPage; p++) {
+        rc = writeDirectoryEntry(managementData, p);
+    }
+    if (rc == RC_OK && dataPages > existingPages) {
+        rc = writeDirectoryHeader(managementData);
+    }
+
+    RC closeRC = closeTable(&rel);
+    if (rowsLoaded != NULL) {
+        *rowsLoaded = storedRows;
+    }
+    if (loadRC != RC_OK) {
+        return loadRC;
+    }
+    return rc != RC_OK ? rc : closeRC;
 }
 
 /*
@@ -656,7 +1254,7 @@ switch (1) {
         if (id.page < 0) {
             return RC_RM_INVALID_RID; // Page number is negative
         }
-        if (id.page >= managementData->numPages) {
+        if (id.page >= numDataPages(managementData)) {
             return RC_RM_INVALID_RID; // Page number exceeds total pages
         }
         if (id.slot < 0) {
@@ -666,7 +1264,7 @@ switch (1) {
 }
 
 // Read the page from the file
-RC rc = pinPage(&managementData->bm, &managementData->pageHndlBM, id.page + managementData->numPageDP + 1);
+RC rc = pinPage(&managementData->bm, &managementData->pageHndlBM, dataPageBlock(id.page));
 if (rc != RC_OK) {
     return rc; // Error handling for pinPage failure
 }
@@ -686,9 +1284,10 @@ if (slotEntry->isFree) {
 // Free the slot by marking it as available
 slotEntry->isFree = true;
 
-// Update the page directory to reflect the increased free space
-managementData->pageDirectory[id.page].freeSpace += (slotEntry->offset - (id.slot * sizeof(SlotDirectoryEntry)));
+// Update the page directory to reflect the increased free space; the slot entry stays for reuse
+managementData->pageDirectory[id.page].freeSpace += slotEntry->length;
 managementData->pageDirectory[id.page].hasFreeSlot = true;
+fsmSetFreeSpace(&managementData->freeSpace, id.page, managementData->pageDirectory[id.page].freeSpace);
 
 // Mark the page as dirty before unpinning
 markDirty(&managementData->bm, &managementData->pageHndlBM);
@@ -699,6 +1298,11 @@ if (rc != RC_OK) {
     return rc; // Error handling for unpinPage failure
 }
 
+rc = writeDirectoryEntry(managementData, id.page);
+if (rc != RC_OK) {
+    return rc;
+}
+
 
     return RC_OK;
 }
@@ -707,7 +1311,8 @@ if (rc != RC_OK) {
 /*
  * Updates a record in the table.
  * This function updates the data of a record in the table with the provided record.
- * If the updated record does not fit in the original slot, it is treated as a new record.
+ * A record that grows is moved within its page, which is compacted if needed; only
+ * if the page has no room left is it deleted and inserted again under a new RID.
  *
  * Parameters:
  * - rel: Pointer to the RM_TableData structure representing the table.
@@ -720,6 +1325,7 @@ if (rc != RC_OK) {
  */
 extern RC updateRecord(RM_TableData *rel, Record *record) {
     RM_managementData *managementData = (RM_managementData *) rel->managementData;
+    LATENCY_START(start);
 
     // Check if the RID is valid
    // Validate the record ID (RID)
@@ -728,7 +1334,7 @@ switch (1) {
         if (record->id.page < 0) {
             return RC_RM_INVALID_RID; // Page number is invalid
         }
-        if (record->id.page >= managementData->numPages) {
+        if (record->id.page >= numDataPages(managementData)) {
             return RC_RM_INVALID_RID; // Page number exceeds total pages
         }
         if (record->id.slot < 0) {
@@ -740,7 +1346,7 @@ switch (1) {
 }
 
 // Read the page from the file
-RC rc = pinPage(&managementData->bm, &managementData->pageHndlBM, record->id.page + managementData->numPageDP + 1);
+RC rc = pinPage(&managementData->bm, &managementData->pageHndlBM, dataPageBlock(record->id.page));
 if (rc != RC_OK) {
     return rc; // Error handling for pinPage failure
 }
@@ -757,43 +1363,60 @@ if (slotEntry->isFree) {
 }
 
 
-// Determine the size of the record
-int recSize = getRecordSize(rel->schema);
-
-// Calculate available space, including the difference from the existing record's slot
-int availableSpace = managementData->pageDirectory[record->id.page].freeSpace + 
-                     (slotEntry->offset - (record->id.slot * sizeof(SlotDirectoryEntry)));
+// Sizes of the stored record before and after the update
+char packed[PAGE_SIZE];
+int newSize;
+const char *stored = storedRecord(rel->schema, record->data, packed, &newSize);
+int oldSize = slotEntry->length;
+PageDirectoryEntry *entry = &managementData->pageDirectory[record->id.page];
 
 // Check if the new record fits in the existing page space
 // Determine the action based on record size compared to available space
-int action = (recSize > availableSpace) ? 1 : 0; // 1 for delete and insert, 0 for update
+int action = (newSize - oldSize > entry->freeSpace) ? 1 : 0; // 1 for delete and insert, 0 for update
 
 switch (action) {
     case 1: { // Delete and insert
+        // Both pin pages through the table's page handle, so release it first
+        unpinPage(&managementData->bm, &managementData->pageHndlBM);
+
         // Remove the current record and insert a new one if it doesn't fit
         RC resultCode = deleteRecord(rel, record->id);
         if (resultCode != RC_OK) {
-            unpinPage(&managementData->bm, &managementData->pageHndlBM);
             return resultCode; // Error handling for deleteRecord failure
         }
 
         resultCode = insertRecord(rel, record);
         if (resultCode != RC_OK) {
-            unpinPage(&managementData->bm, &managementData->pageHndlBM);
             return resultCode; // Error handling for insertRecord failure
         }
-        break; // Break out of switch after handling the case
+        LATENCY_RECORD(LAT_UPDATE_RECORD, start);
+        return RC_OK;
     }
     case 0: { // Update existing record
-        // Update the existing record within the page
-        void *destination = pageData + slotEntry->offset;  // Calculate destination pointer
-        memcpy(destination, record->data, recSize);         // Copy the new record data
+        // A record that grows moves to the page's free bytes, compacting the
+        // page first if they are fragmented; the slot, and so the RID, stays
+        int recordOffset = slotEntry->offset;
+        if (newSize > oldSize) {
+            slotEntry->isFree = true;
+            recordOffset = allocateOnPage(pageData, entry->recordCount,
+                                          entry->recordCount * sizeof(SlotDirectoryEntry), newSize);
+            slotEntry->isFree = false;
+        }
+        memcpy(pageData + recordOffset, stored, newSize);
+        slotEntry->offset = recordOffset;
+        slotEntry->length = newSize;
 
         // Adjust the free space in the page directory
         int pageIndex = record->id.page;                    // Get the page index
-        int slotOffset = slotEntry->offset;                  // Get the slot offset
-        int slotSize = record->id.slot * sizeof(SlotDirectoryEntry); // Calculate the size of the slot
-        managementData->pageDirectory[pageIndex].freeSpace -= (recSize - (slotOffset - slotSize));
+        if (newSize != oldSize) {
+            entry->freeSpace -= newSize - oldSize;
+            fsmSetFreeSpace(&managementData->freeSpace, pageIndex, entry->freeSpace);
+            rc = writeDirectoryEntry(managementData, pageIndex);
+            if (rc != RC_OK) {
+                unpinPage(&managementData->bm, &managementData->pageHndlBM);
+                return rc;
+            }
+        }
         break; // Break out of switch after handling the case
     }
     default:
@@ -811,20 +1434,22 @@ markDirty(&managementData->bm, &managementData->pageHndlBM);
         return rc; // Error handling for unpinPage failure
     }
 
+    LATENCY_RECORD(LAT_UPDATE_RECORD, start);
     return RC_OK;
 }
 
 
 extern RC getRecord(RM_TableData *table, RID recordID, Record *resultRecord) {
     RM_managementData *mgmtData = (RM_managementData *)table->managementData;
+    LATENCY_START(start);
 
     // Validate the given Record ID (RID)
-    if (!(recordID.page >= 0 && recordID.page < mgmtData->numPages && recordID.slot >= 0)) {
+    if (!(recordID.page >= 0 && recordID.page < numDataPages(mgmtData) && recordID.slot >= 0)) {
         return RC_RM_INVALID_RID;
     }
 
     // Pin the appropriate page in the buffer pool
-    int targetPage = recordID.page + mgmtData->numPageDP + 1;
+    int targetPage = dataPageBlock(recordID.page);
     RC pinStatus = pinPage(&mgmtData->bm, &mgmtData->pageHndlBM, targetPage);
     if (pinStatus != RC_OK) {
         return pinStatus; // Return immediately if page pinning fails
@@ -843,19 +1468,84 @@ extern RC getRecord(RM_TableData *table, RID recordID, Record *resultRecord) {
             break;
     }
 
-    // Fetch the size of the record based on the schema
-    int recSize = getRecordSize(table->schema);
-
     // Copy the record data into the result record
     resultRecord->id = recordID;
-    memcpy(resultRecord->data, pageContent + slotEntry->offset, recSize);
+    readStoredRecord(table->schema, pageContent, slotEntry, resultRecord->data);
 
     // Safely unpin the page and check for any issues
     RC unpinStatus = unpinPage(&mgmtData->bm, &mgmtData->pageHndlBM);
+    LATENCY_RECORD(LAT_GET_RECORD, start);
     return unpinStatus == RC_OK ? RC_OK : unpinStatus;
 }
 
 
+/*
+ * Gets several records by their RIDs in one call.
+ * All data pages involved are pinned with a single pinPages batch, so pages that
+ * are not yet resident are read together rather than one miss at a time.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ * - ids: Array of n Record IDs to fetch.
+ * - records: Array of n records, created with createRecord, receiving the data.
+ * - n: Number of records to fetch.
+ *
+ * Returns:
+ * - RC_OK: All records were retrieved successfully.
+ * - RC_RM_INVALID_RID: One of the RIDs is invalid.
+ * - RC_RM_RECORD_NOT_FOUND: One of the RIDs refers to a free slot.
+ */
+extern RC getRecords(RM_TableData *rel, RID *ids, Record **records, int n) {
+    if (rel == NULL || ids == NULL || records == NULL || n <= 0) {
+        return RC_RM_NULL_POINTER;
+    }
+
+    RM_managementData *mgmtData = (RM_managementData *)rel->managementData;
+
+    // Validate every RID before touching the buffer pool
+    for (int k = 0; k < n; k++) {
+        if (!(ids[k].page >= 0 && ids[k].page < numDataPages(mgmtData) && ids[k].slot >= 0)) {
+            return RC_RM_INVALID_RID;
+        }
+    }
+
+    PageNumber *pageNums = (PageNumber *)malloc(n * sizeof(PageNumber));
+    BM_PageHandle *handles = (BM_PageHandle *)calloc(n, sizeof(BM_PageHandle));
+    if (pageNums == NULL || handles == NULL) {
+        free(pageNums);
+        free(handles);
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+
+    for (int k = 0; k < n; k++) {
+        pageNums[k] = dataPageBlock(ids[k].page);
+    }
+
+    // Pin every page in one batch
+    RC rc = pinPages(&mgmtData->bm, handles, pageNums, n);
+    if (rc != RC_OK) {
+        free(pageNums);
+        free(handles);
+        return rc;
+    }
+
+    for (int k = 0; k < n && rc == RC_OK; k++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(handles[k].data + (ids[k].slot * sizeof(SlotDirectoryEntry)));
+        if (slotEntry->isFree) {
+            rc = RC_RM_RECORD_NOT_FOUND;
+            break;
+        }
+        records[k]->id = ids[k];
+        readStoredRecord(rel->schema, handles[k].data, slotEntry, records[k]->data);
+    }
+
+    RC unpinStatus = unpinPages(&mgmtData->bm, handles, n);
+    free(pageNums);
+    free(handles);
+    return rc != RC_OK ? rc : unpinStatus;
+}
+
+
 /*
  * Initializes a scan operation on the table based on the given condition.
  * This function initializes the RM_ScanHandle data structure passed as an argument to startScan.
@@ -885,43 +1575,23 @@ if (!scanInfo) {
 scan->rel = rel; 
 scan->mgmtData = scanInfo;
 
-
-    RM_managementData *managementData = (RM_managementData *)rel->managementData;
-
-    // Read the first page of the table (data pages start at page 2)
-    RC rc = pinPage(&managementData->bm, &managementData->pageHndlBM, 2);
-    if (rc != RC_OK) {
-        free(scanInfo); // Free allocated memory on failure
-        return rc; // Error handling for pinPage failure
-    }
-
+    // next pins each data page only while it reads it, so no page is pinned here
     return RC_OK; // Scan initialization successful
 }
 
 
 
-int ceiling(int numerator, int denominator) {
-    int quotient = numerator / denominator;
-    if (numerator % denominator != 0) {
-        quotient += 1;
-    }
-    return quotient;
-}
-
-
 extern RC next (RM_ScanHandle *scan, Record *record) {
     // Extract relevant data from scan and rel objects
 ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
 RM_TableData *rel = scan->rel;
 RM_managementData *managementData = (RM_managementData *)rel->managementData;
-
-// Calculate maximum entries and record size in a more streamlined manner
-int maxEntriesInPD = (PAGE_SIZE - (2 * sizeof(int))) / sizeof(PageDirectoryEntry), recordSize = getRecordSize(rel->schema);
+LATENCY_START(start);
 
     // Loop to find the next available record
-    for (; scanInfo->currentPage <= managementData->numPages - managementData->numPageDP; scanInfo->currentPage++) {
+    for (; scanInfo->currentPage < numDataPages(managementData); scanInfo->currentPage++) {
 
-        int pageNumPin = ceiling(scanInfo->currentPage + 1, maxEntriesInPD) + 1 + scanInfo->currentPage;
+        int pageNumPin = dataPageBlock(scanInfo->currentPage);
         pinPage(&managementData->bm, &managementData->pageHndlBM, pageNumPin);
         SM_PageHandle pageHandle = managementData->pageHndlBM.data;
 
@@ -941,23 +1611,21 @@ for (int slotIdx = scanInfo->currentSlot;
     record->id.slot = slotIdx;
 
     // Copy record data into the record structure
-    // Copy record data to record->data
-    void *source = pageHandle + slotEntry->offset;
-    void *destination = record->data;
-    memcpy(destination, source, recordSize);
-
-    // Perform condition evaluation
-    Value *result = NULL;
-    evalExpr(record, rel->schema, scanInfo->condition, &result);
-
+    readStoredRecord(rel->schema, pageHandle, slotEntry, record->data);
 
     // Check if the record meets the condition or if there is no condition
-    bool shouldReturn = (result->v.boolV == TRUE) || (scanInfo->condition == NULL);
-    freeVal(result);  // Free evaluation result
+    bool shouldReturn = true;
+    if (scanInfo->condition != NULL) {
+        Value *result = NULL;
+        evalExpr(record, rel->schema, scanInfo->condition, &result);
+        shouldReturn = (result->v.boolV == TRUE);
+        freeVal(result);  // Free evaluation result
+    }
 
     if (shouldReturn) {
         unpinPage(&managementData->bm, &managementData->pageHndlBM);
         scanInfo->currentSlot = slotIdx + 1;  // Increment for the next call
+        LATENCY_RECORD(LAT_SCAN_NEXT, start);
         return RC_OK; // Return successfully if condition is met
         }
     }
@@ -969,6 +1637,7 @@ for (int slotIdx = scanInfo->currentSlot;
         unpinPage(&managementData->bm, &managementData->pageHndlBM);
     }
 
+    LATENCY_RECORD(LAT_SCAN_NEXT, start);
     return RC_RM_NO_MORE_TUPLES;
 }
 
@@ -990,17 +1659,7 @@ extern RC closeScan(RM_ScanHandle *scan) {
     ScanInfo *scanInfo = (ScanInfo *) scan->mgmtData;
     if (!scanInfo) return RC_RM_SCAN_INFO_NULL; // Return error if scanInfo is NULL
 
-   RM_managementData *managementData = (RM_managementData *) scan->rel->managementData;
-
-    // Safely unpin the current page if it was pinned
-    if (scanInfo->currentPage >= 0 && scanInfo->currentPage < managementData->numPages) {
-        RC unpinResult = unpinPage(&managementData->bm, &managementData->pageHndlBM);
-        if (unpinResult != RC_OK) {
-            // Log the error if unpinning fails (assuming a logging function exists)
-            // logError("Failed to unpin page during closeScan.");
-            return unpinResult; // Return the error from unpinning
-        }
-    }
+    // next unpins every page before it returns, so the scan holds no pin here
 
     // Clean up by freeing the memory for ScanInfo
     free(scanInfo);
@@ -1012,26 +1671,324 @@ extern RC closeScan(RM_ScanHandle *scan) {
     return RC_OK; // Return success
 }
 
-extern int getRecordSize(Schema *schema) {
-    // Return the size in bytes of records for a given schema
-    int recordSize = 0, numAttr = schema->numAttr;
+// Whether a directory entry describes a page without records; free slots count as free space
+static inline bool pageIsEmpty(PageDirectoryEntry *entry) {
+    return entry->freeSpace + entry->recordCount * (int) sizeof(SlotDirectoryEntry) == PAGE_SIZE;
+}
 
+/*
+ * Trims the free slots at the end of a data page's slot array, recounts its
+ * free bytes from the slots and compacts it if they are fragmented.
+ */
+static RC vacuumPage(RM_managementData *managementData, int page, RM_VacuumStats *stats) {
+    BM_PageHandle handle;
+    memset(&handle, 0, sizeof(handle));
+    RC rc = pinPage(&managementData->bm, &handle, dataPageBlock(page));
+    if (rc != RC_OK) {
+        return rc;
+    }
 
-    for (int i = 0; i < numAttr; i++) {
-        if (schema->dataTypes[i] == DT_INT) {
-            recordSize += sizeof(int);
-        } else if (schema->dataTypes[i] == DT_FLOAT) {
-            recordSize += sizeof(float);
-        } else if (schema->dataTypes[i] == DT_STRING) {
-            recordSize += schema->typeLength[i];
-        } else if (schema->dataTypes[i] == DT_BOOL) {
-            recordSize += sizeof(bool);
-        } else {
-            // Handle unsupported data types if necessary
+    PageDirectoryEntry *entry = &managementData->pageDirectory[page];
+    int numSlots = entry->recordCount;
+    while (numSlots > 0 && ((SlotDirectoryEntry *)(handle.data + (numSlots - 1) * sizeof(SlotDirectoryEntry)))->isFree) {
+        numSlots--;
+    }
+    int freeSpace = PAGE_SIZE - numSlots * sizeof(SlotDirectoryEntry);
+    for (int z = 0; z < numSlots; z++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(handle.data + z * sizeof(SlotDirectoryEntry));
+        if (!slotEntry->isFree) {
+            freeSpace -= slotEntry->length;
         }
     }
 
-    return recordSize;
+    bool changed = numSlots != entry->recordCount || freeSpace != entry->freeSpace;
+    if (recordsStart(handle.data, numSlots) - numSlots * (int) sizeof(SlotDirectoryEntry) < freeSpace) {
+        compactPage(handle.data, numSlots);
+        stats->pagesCompacted++;
+        markDirty(&managementData->bm, &handle);
+    }
+    stats->slotsTrimmed += entry->recordCount - numSlots;
+    if (freeSpace > entry->freeSpace) {
+        stats->bytesReclaimed += freeSpace - entry->freeSpace;
+    }
+    unpinPage(&managementData->bm, &handle);
+
+    if (!changed) {
+        return RC_OK;
+    }
+    entry->recordCount = numSlots;
+    entry->freeSpace = freeSpace;
+    entry->hasFreeSlot = freeSpace > 0;
+    fsmSetFreeSpace(&managementData->freeSpace, page, freeSpace);
+    return writeDirectoryEntry(managementData, page);
+}
+
+/*
+ * Moves the records of a data page into earlier pages with room, reporting
+ * every move, and sets *emptied if none is left. The page is kept out of the
+ * free-space map, so neither its own records nor new inserts land on it.
+ */
+static RC drainPage(RM_VacuumHandle *vacuum, int page, bool *emptied) {
+    RM_managementData *managementData = (RM_managementData *) vacuum->rel->managementData;
+    PageDirectoryEntry *entry = &managementData->pageDirectory[page];
+    BM_PageHandle source, target;
+    memset(&source, 0, sizeof(source));
+    memset(&target, 0, sizeof(target));
+
+    fsmSetFreeSpace(&managementData->freeSpace, page, 0);
+    if (page < vacuum->firstDrained) {
+        vacuum->firstDrained = page;
+    }
+    RC rc = pinPage(&managementData->bm, &source, dataPageBlock(page));
+    if (rc != RC_OK) {
+        return rc;
+    }
+
+    *emptied = true;
+    for (int z = 0; z < entry->recordCount && rc == RC_OK; z++) {
+        SlotDirectoryEntry *slotEntry = (SlotDirectoryEntry *)(source.data + z * sizeof(SlotDirectoryEntry));
+        if (slotEntry->isFree) {
+            continue;
+        }
+
+        // Pages after this one are empty and out of the map too, so any page found comes before it
+        int targetPage = fsmFindPage(&managementData->freeSpace, slotEntry->length + sizeof(SlotDirectoryEntry));
+        if (targetPage == FSM_NO_PAGE) {
+            *emptied = false;
+            break;
+        }
+        rc = pinPage(&managementData->bm, &target, dataPageBlock(targetPage));
+        if (rc != RC_OK) {
+            break;
+        }
+        PageDirectoryEntry *targetEntry = &managementData->pageDirectory[targetPage];
+        int slotCursor = 0;
+        RID to = { targetPage, placeRecord(target.data, targetEntry, source.data + slotEntry->offset,
+                                           slotEntry->length, &slotCursor) };
+        markDirty(&managementData->bm, &target);
+        unpinPage(&managementData->bm, &target);
+        fsmSetFreeSpace(&managementData->freeSpace, targetPage, targetEntry->freeSpace);
+        rc = writeDirectoryEntry(managementData, targetPage);
+
+        slotEntry->isFree = true;
+        entry->freeSpace += slotEntry->length;
+        vacuum->stats.recordsMoved++;
+        vacuum->moved(vacuum->context, (RID) { page, z }, to);
+    }
+
+    // An emptied page gives up its slots as well
+    if (rc == RC_OK && *emptied) {
+        vacuum->stats.slotsTrimmed += entry->recordCount;
+        vacuum->stats.bytesReclaimed += entry->recordCount * sizeof(SlotDirectoryEntry);
+        entry->recordCount = 0;
+        entry->freeSpace = PAGE_SIZE;
+        entry->hasFreeSlot = true;
+    }
+    markDirty(&managementData->bm, &source);
+    unpinPage(&managementData->bm, &source);
+    if (rc != RC_OK) {
+        *emptied = false;
+        return rc;
+    }
+    return writeDirectoryEntry(managementData, page);
+}
+
+/*
+ * Cuts the empty data pages at the end of the table, with the directory
+ * pages of the groups they leave empty, from the buffer pool and the file.
+ * The first data page always stays.
+ */
+static RC truncateEmptyPages(RM_VacuumHandle *vacuum) {
+    RM_managementData *managementData = (RM_managementData *) vacuum->rel->managementData;
+    int numData = numDataPages(managementData);
+    int keep = numData;
+    while (keep > 1 && pageIsEmpty(&managementData->pageDirectory[keep - 1])) {
+        keep--;
+    }
+
+    // Pages drained without being cut take inserts again
+    for (int page = vacuum->firstDrained; page < keep; page++) {
+        fsmSetFreeSpace(&managementData->freeSpace, page, managementData->pageDirectory[page].freeSpace);
+    }
+    vacuum->firstDrained = keep;
+    if (keep == numData) {
+        return RC_OK;
+    }
+
+    int oldBlocks = dataPageBlock(numData - 1) + 1;
+    int newBlocks = dataPageBlock(keep - 1) + 1;
+    RC rc = truncatePool(&managementData->bm, newBlocks);
+    if (rc == RC_OK) {
+        rc = truncatePageFile(newBlocks, &managementData->fileHndl);
+    }
+    if (rc != RC_OK) {
+        return rc;
+    }
+
+    // A metrics snapshot may be reading the directory
+    metricsLockSources();
+    managementData->numPageDP = (keep + PAGE_DIRECTORY_ENTRIES - 1) / PAGE_DIRECTORY_ENTRIES;
+    managementData->numPages = keep + managementData->numPageDP - 1;
+    PageDirectoryEntry *pageDirectory = (PageDirectoryEntry *) realloc(managementData->pageDirectory,
+                                                                      keep * sizeof(PageDirectoryEntry));
+    if (pageDirectory != NULL) {
+        managementData->pageDirectory = pageDirectory;
+    }
+    metricsUnlockSources();
+    fsmTruncate(&managementData->freeSpace, keep);
+
+    vacuum->stats.pagesTruncated += oldBlocks - newBlocks;
+    vacuum->stats.bytesReclaimed += (long) (oldBlocks - newBlocks) * PAGE_SIZE;
+    return writeDirectoryHeader(managementData);
+}
+
+/*
+ * Starts an incremental vacuum of an open table. vacuumStep then does the
+ * work a few pages at a time, so other operations can run between steps:
+ * 1. Every data page has the free slots at the end of its slot array
+ *    trimmed, its free bytes recounted and, if they are fragmented,
+ *    compacted. Records keep their RIDs.
+ * 2. If moved is given, the records of the last pages are moved into free
+ *    bytes of earlier pages, one whole page at a time while the earlier
+ *    pages have room for it, and every move is reported to moved.
+ * 3. The empty pages at the end of the table are cut from the file, and
+ *    the page directory is rewritten for the remaining pages.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ * - vacuum: Handle receiving the vacuum's state.
+ * - moved: Callback told about records that move, or NULL to move none.
+ * - context: Passed to moved.
+ *
+ * Returns:
+ * - RC_OK: The vacuum was started.
+ * - RC_RM_NULL_POINTER: The table is not open or vacuum is NULL.
+ */
+extern RC startVacuum(RM_TableData *rel, RM_VacuumHandle *vacuum, RM_RecordMoved moved, void *context) {
+    if (rel == NULL || rel->managementData == NULL || vacuum == NULL) {
+        return RC_RM_NULL_POINTER;
+    }
+
+    memset(vacuum, 0, sizeof(RM_VacuumHandle));
+    vacuum->rel = rel;
+    vacuum->moved = moved;
+    vacuum->context = context;
+    vacuum->phase = VACUUM_COMPACT;
+    vacuum->nextPage = 0;
+    vacuum->firstDrained = numDataPages((RM_managementData *) rel->managementData);
+    return RC_OK;
+}
+
+/*
+ * Runs a vacuum for at most maxPages pages compacted or drained, and sets
+ * *done once it has finished. Pages added or changed between steps are
+ * taken as they are found.
+ *
+ * Parameters:
+ * - vacuum: Handle set up by startVacuum.
+ * - maxPages: Number of pages this step may compact or drain.
+ * - done: Set to true when the vacuum has finished, false otherwise.
+ *
+ * Returns:
+ * - RC_OK: The step ran; vacuum->stats holds the totals so far.
+ * - RC_BP_TRUNCATE_ERROR: A page at the end of the table is pinned; the
+ *   vacuum finishes without cutting it.
+ * - Any error of the buffer pool or the storage manager.
+ */
+extern RC vacuumStep(RM_VacuumHandle *vacuum, int maxPages, bool *done) {
+    if (vacuum == NULL || vacuum->rel == NULL || done == NULL) {
+        return RC_RM_NULL_POINTER;
+    }
+    RM_managementData *managementData = (RM_managementData *) vacuum->rel->managementData;
+    RC rc = RC_OK;
+
+    while (rc == RC_OK && vacuum->phase != VACUUM_DONE && maxPages > 0) {
+        int numData = numDataPages(managementData);
+        switch (vacuum->phase) {
+            case VACUUM_COMPACT:
+                if (vacuum->nextPage >= numData) {
+                    vacuum->phase = vacuum->moved != NULL ? VACUUM_MERGE : VACUUM_TRUNCATE;
+                    break;
+                }
+                rc = vacuumPage(managementData, vacuum->nextPage++, &vacuum->stats);
+                maxPages--;
+                break;
+
+            case VACUUM_MERGE: {
+                // The last page with records, keeping the empty ones after it out of the map
+                int source = numData - 1;
+                while (source > 0 && pageIsEmpty(&managementData->pageDirectory[source])) {
+                    fsmSetFreeSpace(&managementData->freeSpace, source, 0);
+                    if (source < vacuum->firstDrained) {
+                        vacuum->firstDrained = source;
+                    }
+                    source--;
+                }
+
+                // Drain it only while the earlier pages have room for all of it; the pages
+                // after it are out of the free-space map, so the rest of the map is theirs
+                long available = managementData->freeSpace.totalFree
+                                 - fsmGetFreeSpace(&managementData->freeSpace, source);
+                if (source == 0 || available < PAGE_SIZE - managementData->pageDirectory[source].freeSpace) {
+                    vacuum->phase = VACUUM_TRUNCATE;
+                    break;
+                }
+
+                bool emptied;
+                rc = drainPage(vacuum, source, &emptied);
+                if (rc == RC_OK && !emptied) {
+                    vacuum->phase = VACUUM_TRUNCATE;
+                }
+                maxPages--;
+                break;
+            }
+
+            case VACUUM_TRUNCATE:
+                rc = truncateEmptyPages(vacuum);
+                vacuum->phase = VACUUM_DONE;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    *done = vacuum->phase == VACUUM_DONE;
+    return rc;
+}
+
+/*
+ * Vacuums a table in one go; see startVacuum.
+ *
+ * Parameters:
+ * - rel: Pointer to the RM_TableData structure representing the table.
+ * - moved: Callback told about records that move, or NULL to move none.
+ * - context: Passed to moved.
+ * - stats: Receives the work done and the space reclaimed, or NULL.
+ *
+ * Returns:
+ * - RC_OK: The table was vacuumed.
+ * - Any error of startVacuum or vacuumStep.
+ */
+extern RC vacuumTable(RM_TableData *rel, RM_RecordMoved moved, void *context, RM_VacuumStats *stats) {
+    RM_VacuumHandle vacuum;
+    bool done = false;
+
+    memset(&vacuum, 0, sizeof(vacuum));
+    RC rc = startVacuum(rel, &vacuum, moved, context);
+    while (rc == RC_OK && !done) {
+        rc = vacuumStep(&vacuum, VACUUM_STEP_PAGES, &done);
+    }
+    if (stats != NULL) {
+        *stats = vacuum.stats;
+    }
+    return rc;
+}
+
+
+extern int getRecordSize(Schema *schema) {
+    // Return the size in bytes of records for a given schema, null bitmap included
+    return schema->attrOffsets[schema->numAttr];
 }
 
 
@@ -1123,6 +2080,13 @@ extern Schema *createSchema(int numAttr, char **attrNames, DataType *dataTypes,
         schema->keyAttrs[i] = keys[i];
     }
 
+    // Lay out the attributes of its records
+    if (initSchemaLayout(schema) != RC_OK) {
+        printf("Error: Layout of the schema's records failed.\n");
+        freeSchema(schema);
+        return NULL;
+    }
+
     // Log successful schema creation
     printf("Schema created successfully.\n");
 
@@ -1182,6 +2146,10 @@ extern RC freeSchema(Schema *schema) {
         schema->keyAttrs = NULL; // Set pointer to NULL after freeing
     }
 
+    // Free the attribute offsets
+    free(schema->attrOffsets);
+    schema->attrOffsets = NULL;
+
     // Free the memory for the schema structure itself
     free(schema);
     schema = NULL; // Set pointer to NULL after freeing
@@ -1251,8 +2219,8 @@ extern RC createRecord(Record **record, Schema *schema) {
     // Initialize the record's data buffer to zero
     memset(newRecord->data, 0, recordSize);
 
-    // Log successful record creation
-    printf("Successfully created a new record at address %p with size %zu bytes.\n", (void *)newRecord, recordSize);
+    // Trace successful record creation
+    TRACE_DEBUG(TE_CREATE_RECORD, (uintptr_t)newRecord, recordSize);
 
     // Assign the newly created record to the output pointer
     *record = newRecord; // Set the output pointer to point to the new record
@@ -1278,26 +2246,20 @@ extern RC freeRecord (Record *record) {
         return RC_OK;
     }
 
-    // Log the action of freeing the record
-    printf("Freeing record at address %p\n", (void *)record);
+    // Trace the action of freeing the record
+    TRACE_DEBUG(TE_FREE_RECORD, (uintptr_t)record, 0);
 
     // Check if the record's data pointer is valid before freeing
     if (record->data != NULL) {
         // Free the memory allocated for the record's data
         free(record->data);
         record->data = NULL; // Set pointer to NULL after freeing for safety
-    } else {
-        // Log if the record's data was already NULL
-        printf("Record's data pointer is already NULL at address %p\n", (void *)record);
     }
 
     // Free the record structure itself
     free(record);
     record = NULL; // Set pointer to NULL after freeing for safety
 
-    // Log that the record has been successfully freed
-    printf("Record successfully freed.\n");
-
     // Return success status
     return RC_OK;
 }
@@ -1306,30 +2268,27 @@ extern RC freeRecord (Record *record) {
 // Sets the attribute values of a record for a given schema
 extern RC setAttr(Record *record, Schema *schema, int attrNum, Value *value) {
 
-    // Validate attribute number and data type
-if (attrNum < 0 || attrNum >= schema->numAttr || value->dt != schema->dataTypes[attrNum]) {
+    // Validate attribute number and data type; varchar attributes take string values, any attribute NULL
+if (attrNum < 0 || attrNum >= schema->numAttr
+        || (value->dt != schema->dataTypes[attrNum] && value->dt != DT_NULL
+            && !(value->dt == DT_STRING && schema->dataTypes[attrNum] == DT_VARCHAR))) {
     return (attrNum < 0 || attrNum >= schema->numAttr) 
             ? RC_RM_INVALID_ATTRIBUTE // Invalid attribute number
             : RC_RM_ATTRIBUTE_TYPE_MISMATCH; // Type mismatch error
 }
 
 
-    // Calculate the offset of the attribute within the record's data buffer based on schema
-    int attrOffset = 0;
-    for (int i = 0; i < attrNum; i++) {
-        if (schema->dataTypes[i] == DT_INT) {
-            attrOffset += sizeof(int);
-        } else if (schema->dataTypes[i] == DT_FLOAT) {
-            attrOffset += sizeof(float);
-        } else if (schema->dataTypes[i] == DT_BOOL) {
-            attrOffset += sizeof(bool);
-        } else if (schema->dataTypes[i] == DT_STRING) {
-            attrOffset += schema->typeLength[i];
-        } else {
-            // Handle unsupported data types
-            return RC_RM_DATA_TYPE_ERROR; // Unsupported data type error
-        }
+    // Look up the offset of the attribute within the record's data buffer
+    int attrOffset = schema->attrOffsets[attrNum];
+
+    // A NULL is a set bit in the null bitmap and zero bytes
+    char nullBit = (char) (1 << (attrNum % 8));
+    if (value->dt == DT_NULL) {
+        record->data[attrNum / 8] |= nullBit;
+        memset(record->data + attrOffset, 0, attrSize(schema, attrNum));
+        return RC_OK;
     }
+    record->data[attrNum / 8] &= ~nullBit;
 
     // Copy the attribute value from the Value structure to the record's data buffer
     if (schema->dataTypes[attrNum] == DT_INT) {
@@ -1338,7 +2297,7 @@ if (attrNum < 0 || attrNum >= schema->numAttr || value->dt != schema->dataTypes[
         memcpy(record->data + attrOffset, &(value->v.floatV), sizeof(float));
     } else if (schema->dataTypes[attrNum] == DT_BOOL) {
         memcpy(record->data + attrOffset, &(value->v.boolV), sizeof(bool));
-    } else if (schema->dataTypes[attrNum] == DT_STRING) {
+    } else if (schema->dataTypes[attrNum] == DT_STRING || schema->dataTypes[attrNum] == DT_VARCHAR) {
         strncpy(record->data + attrOffset, value->v.stringV, schema->typeLength[attrNum]);
     } else {
         // Handle unsupported data types
@@ -1351,27 +2310,12 @@ if (attrNum < 0 || attrNum >= schema->numAttr || value->dt != schema->dataTypes[
 
 // Retrieves the attribute value of a record for a given schema.
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value) {
-    // Calculate the offset of the attribute within the record's data buffer based on schema
-    int attrOffset = 0;
-
-    // Calculate the offset for the attribute specified by attrNum
-    int i = 0;
-while (i < attrNum) {
-    if (schema->dataTypes[i] == DT_INT) {
-        attrOffset += sizeof(int);
-    } else if (schema->dataTypes[i] == DT_FLOAT) {
-        attrOffset += sizeof(float);
-    } else if (schema->dataTypes[i] == DT_STRING) {
-        attrOffset += schema->typeLength[i];
-    } else if (schema->dataTypes[i] == DT_BOOL) {
-        attrOffset += sizeof(bool);
-    } else {
-        // Handle unsupported data types, if necessary
-        return RC_RM_DATA_TYPE_ERROR; // or an appropriate error code
+    if (attrNum < 0 || attrNum >= schema->numAttr) {
+        return RC_RM_INVALID_ATTRIBUTE;
     }
-    i++;
-}
 
+    // Look up the offset of the attribute within the record's data buffer
+    int attrOffset = schema->attrOffsets[attrNum];
 
     // Allocate memory for the Value structure to store the attribute value
     *value = (Value *)malloc(sizeof(Value));
@@ -1379,8 +2323,12 @@ while (i < attrNum) {
         return RC_MALLOC_ERROR; // or an appropriate error code
     }
 
-    // Set the data type of the attribute value
-    (*value)->dt = schema->dataTypes[attrNum];
+    // Set the data type of the attribute value; a varchar is read as a string
+    (*value)->dt = schema->dataTypes[attrNum] == DT_VARCHAR ? DT_STRING : schema->dataTypes[attrNum];
+    if (isAttrNull(record, schema, attrNum)) {
+        (*value)->dt = DT_NULL;
+        return RC_OK;
+    }
 
     // Copy the attribute value from the record's data buffer to the Value structure
     if ((*value)->dt == DT_INT) {
@@ -1411,3 +2359,72 @@ while (i < attrNum) {
 }
 
 
+// Tests the null bit of an attribute, without reading its value
+extern bool isAttrNull(Record *record, Schema *schema, int attrNum) {
+    if (attrNum < 0 || attrNum >= schema->numAttr) {
+        return false;
+    }
+    return (record->data[attrNum / 8] & (1 << (attrNum % 8))) != 0;
+}
+
+
+// Checks an attribute read by a typed accessor: its number, its type (varchar
+// attributes read as strings) and its null bit
+static RC checkTypedAttr(Record *record, Schema *schema, int attrNum, DataType dt) {
+    if (attrNum < 0 || attrNum >= schema->numAttr) {
+        return RC_RM_INVALID_ATTRIBUTE;
+    }
+    DataType attrType = schema->dataTypes[attrNum] == DT_VARCHAR ? DT_STRING : schema->dataTypes[attrNum];
+    if (attrType != dt) {
+        return RC_RM_ATTRIBUTE_TYPE_MISMATCH;
+    }
+    if (record->data[attrNum / 8] & (1 << (attrNum % 8))) {
+        return RC_RM_NULL_VALUE;
+    }
+    return RC_OK;
+}
+
+/*
+ * Typed attribute accessors. Unlike getAttr, they allocate nothing: the
+ * value is copied to *value, or, for strings, pointed to in the record.
+ *
+ * Returns:
+ * - RC_OK on success, RC_RM_INVALID_ATTRIBUTE for an attribute number out of
+ *   range, RC_RM_ATTRIBUTE_TYPE_MISMATCH if the attribute has another type,
+ *   RC_RM_NULL_VALUE if it is NULL (*value is then left unchanged).
+ */
+extern RC getIntAttr(Record *record, Schema *schema, int attrNum, int *value) {
+    RC rc = checkTypedAttr(record, schema, attrNum, DT_INT);
+    if (rc == RC_OK) {
+        memcpy(value, record->data + schema->attrOffsets[attrNum], sizeof(int));
+    }
+    return rc;
+}
+
+extern RC getFloatAttr(Record *record, Schema *schema, int attrNum, float *value) {
+    RC rc = checkTypedAttr(record, schema, attrNum, DT_FLOAT);
+    if (rc == RC_OK) {
+        memcpy(value, record->data + schema->attrOffsets[attrNum], sizeof(float));
+    }
+    return rc;
+}
+
+extern RC getBoolAttr(Record *record, Schema *schema, int attrNum, bool *value) {
+    RC rc = checkTypedAttr(record, schema, attrNum, DT_BOOL);
+    if (rc == RC_OK) {
+        memcpy(value, record->data + schema->attrOffsets[attrNum], sizeof(bool));
+    }
+    return rc;
+}
+
+// Points *chars at a DT_STRING or DT_VARCHAR attribute in the record's data
+// and sets *length to its length. The characters are not null-terminated
+// when they fill the attribute, and stay valid while the record is unchanged.
+extern RC getStringAttrView(Record *record, Schema *schema, int attrNum, const char **chars, int *length) {
+    RC rc = checkTypedAttr(record, schema, attrNum, DT_STRING);
+    if (rc == RC_OK) {
+        *chars = record->data + schema->attrOffsets[attrNum];
+        *length = strnlen(*chars, schema->typeLength[attrNum]);
+    }
+    return rc;
+}
@@ -15,6 +15,10 @@ typedef struct ScanInfo
 typedef bool (*Condition)(Record *record);
 typedef Record* (*UpdateFunction)(Record *record);
 
+// Fills data (getRecordSize bytes) with the next row of a bulk load and
+// returns RC_OK, or RC_RM_NO_MORE_TUPLES after the last row
+typedef RC (*RM_RowSource)(void *context, Schema *schema, char *data);
+
 // Bookkeeping for scans
 typedef struct RM_ScanHandle
 {
@@ -22,26 +26,72 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// Told about every record a vacuum moves to another page, whose RID changes
+// from from to to; it must not use the table
+typedef void (*RM_RecordMoved)(void *context, RID from, RID to);
+
+// Work done and space reclaimed by a vacuum
+typedef struct RM_VacuumStats
+{
+	int pagesCompacted;   // pages whose fragmented free bytes were made contiguous
+	int slotsTrimmed;     // free slots dropped from the end of slot arrays
+	int recordsMoved;     // records moved off the last pages into earlier ones
+	int pagesTruncated;   // data and directory pages cut from the end of the file
+	long bytesReclaimed;  // free bytes regained on pages that stay, plus the truncated pages
+} RM_VacuumStats;
+
+typedef enum RM_VacuumPhase {
+	VACUUM_COMPACT = 0,   // compact every page and trim its free slots
+	VACUUM_MERGE = 1,     // move the records of the last pages into earlier ones
+	VACUUM_TRUNCATE = 2,  // cut the empty pages at the end of the table
+	VACUUM_DONE = 3
+} RM_VacuumPhase;
+
+// Bookkeeping for an incremental vacuum, from startVacuum to the vacuumStep that finishes it
+typedef struct RM_VacuumHandle
+{
+	RM_TableData *rel;
+	RM_RecordMoved moved;   // NULL: records keep their RIDs, so pages are not merged
+	void *context;
+	RM_VacuumPhase phase;
+	int nextPage;           // next page to compact
+	int firstDrained;       // lowest page kept out of the free-space map while merging
+	RM_VacuumStats stats;
+} RM_VacuumHandle;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
 extern RC openTable (RM_TableData *rel, char *name);
+extern RC openTableWithPoolSize (RM_TableData *rel, char *name, int poolSize);
+extern RC resizeTablePool (RM_TableData *rel, int poolSize);
+extern RC checkpointTable (RM_TableData *rel);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int n);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC getRecords (RM_TableData *rel, RID *ids, Record **records, int n);
+
+// bulk loading a closed table, bypassing the buffer pool
+extern RC bulkLoadTable (char *name, RM_RowSource source, void *context, long *rowsLoaded);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
 extern RC next (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
 
+// vacuum
+extern RC startVacuum (RM_TableData *rel, RM_VacuumHandle *vacuum, RM_RecordMoved moved, void *context);
+extern RC vacuumStep (RM_VacuumHandle *vacuum, int maxPages, bool *done);
+extern RC vacuumTable (RM_TableData *rel, RM_RecordMoved moved, void *context, RM_VacuumStats *stats);
+
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
 extern Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys);
@@ -52,5 +102,12 @@ extern RC createRecord (Record **record, Schema *schema);
 extern RC freeRecord (Record *record);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
+extern bool isAttrNull (Record *record, Schema *schema, int attrNum);
+
+// reading attributes without allocating a Value
+extern RC getIntAttr (Record *record, Schema *schema, int attrNum, int *value);
+extern RC getFloatAttr (Record *record, Schema *schema, int attrNum, float *value);
+extern RC getBoolAttr (Record *record, Schema *schema, int attrNum, bool *value);
+extern RC getStringAttrView (Record *record, Schema *schema, int attrNum, const char **chars, int *length);
 
 #endif // RECORD_MGR_H
@@ -143,9 +143,16 @@ serializeSchema(Schema *schema)
 		case DT_STRING:
 			APPEND(result,"STRING[%i]", schema->typeLength[i]);
 			break;
+		case DT_VARCHAR:
+			APPEND(result,"VARCHAR[%i]", schema->typeLength[i]);
+			break;
 		case DT_BOOL:
 			APPEND_STRING(result,"BOOL");
 			break;
+		case DT_NULL:
+			// only values are NULL, never an attribute's type
+			APPEND_STRING(result,"NULL");
+			break;
 		}
 	}
 	APPEND_STRING(result,")");
@@ -193,6 +200,12 @@ serializeAttr(Record *record, Schema *schema, int attrNum)
 	attrOffset(schema, attrNum, &offset);
 	attrData = record->data + offset;
 
+	if (isAttrNull(record, schema, attrNum))
+	{
+		APPEND(result, "%s:NULL", schema->attrNames[attrNum]);
+		RETURN_STRING(result);
+	}
+
 	switch(schema->dataTypes[attrNum])
 	{
 	case DT_INT:
@@ -203,6 +216,7 @@ serializeAttr(Record *record, Schema *schema, int attrNum)
 	}
 	break;
 	case DT_STRING:
+	case DT_VARCHAR:
 	{
 		char *buf;
 		int len = schema->typeLength[attrNum];
@@ -250,11 +264,15 @@ serializeValue(Value *val)
 		APPEND(result,"%f", val->v.floatV);
 		break;
 	case DT_STRING:
+	case DT_VARCHAR:
 		APPEND(result,"%s", val->v.stringV);
 		break;
 	case DT_BOOL:
 		APPEND_STRING(result, ((val->v.boolV) ? "true" : "false"));
 		break;
+	case DT_NULL:
+		APPEND_STRING(result, "NULL");
+		break;
 	}
 
 	RETURN_STRING(result);
@@ -284,6 +302,9 @@ stringToValue(char *val)
 		result->dt = DT_BOOL;
 		result->v.boolV = (val[1] == 't') ? TRUE : FALSE;
 		break;
+	case 'n':
+		result->dt = DT_NULL;
+		break;
 	default:
 		result->dt = DT_INT;
 		result->v.intV = -1;
@@ -297,26 +318,6 @@ stringToValue(char *val)
 RC 
 attrOffset (Schema *schema, int attrNum, int *result)
 {
-	int offset = 0;
-	int attrPos = 0;
-
-	for(attrPos = 0; attrPos < attrNum; attrPos++)
-		switch (schema->dataTypes[attrPos])
-		{
-		case DT_STRING:
-			offset += schema->typeLength[attrPos];
-			break;
-		case DT_INT:
-			offset += sizeof(int);
-			break;
-		case DT_FLOAT:
-			offset += sizeof(float);
-			break;
-		case DT_BOOL:
-			offset += sizeof(bool);
-			break;
-		}
-
-	*result = offset;
+	*result = schema->attrOffsets[attrNum];
 	return RC_OK;
 }
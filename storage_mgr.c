@@ -1,12 +1,85 @@
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "trace.h"
+#include "latency.h"
 #include <stdbool.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Most buffers one vectored call accepts
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
 // Default setting of the storage manager status
 bool isInitialized=false;
 
+/*
+ * Transfers a run of pages at a page-aligned position with vectored calls,
+ * retrying on short transfers and splitting runs longer than IOV_MAX pages.
+ * Every call, byte and nanosecond spent blocked is accounted to the handle.
+ */
+static RC transferPages (SM_FileHandle *fHandle, struct iovec *iov, int count, off_t position, bool write) {
+    int fd = fileno(fHandle->mgmtInfo);
+    size_t remaining = (size_t) count * PAGE_SIZE;
+    int first = 0;
+
+    while (remaining > 0) {
+        int batch = count - first < IOV_MAX ? count - first : IOV_MAX;
+        uint64_t start = latencyNow();
+        ssize_t result = write ? pwritev(fd, iov + first, batch, position)
+                               : preadv(fd, iov + first, batch, position);
+        fHandle->ioStats.ioNanos += latencyNow() - start;
+        if (write) {
+            fHandle->ioStats.writeCalls++;
+        } else {
+            fHandle->ioStats.readCalls++;
+        }
+        if (result <= 0) {
+            return write ? RC_WRITE_FAILED : RC_READ_FAILED;
+        }
+        if (write) {
+            fHandle->ioStats.bytesWritten += result;
+        } else {
+            fHandle->ioStats.bytesRead += result;
+        }
+
+        position += result;
+        remaining -= result;
+        while (first < count && (size_t) result >= iov[first].iov_len) {
+            result -= iov[first].iov_len;
+            first++;
+        }
+        if (first < count) {
+            iov[first].iov_base = (char *) iov[first].iov_base + result;
+            iov[first].iov_len -= result;
+        }
+    }
+
+    if (write) {
+        fHandle->ioStats.pagesWritten += count;
+    } else {
+        fHandle->ioStats.pagesRead += count;
+    }
+    return RC_OK;
+}
+
+/*
+ * Re-reads the page count from the file itself. Another handle on the same
+ * file may have grown it since this handle was opened.
+ */
+static void refreshNumPages (SM_FileHandle *fHandle) {
+    struct stat fileStat;
+    fflush(fHandle->mgmtInfo);
+    if (fstat(fileno(fHandle->mgmtInfo), &fileStat) == 0 && fileStat.st_size / PAGE_SIZE > fHandle->totalNumPages) {
+        fHandle->totalNumPages = fileStat.st_size / PAGE_SIZE;
+    }
+}
+
 /* manipulating page files */
 void initStorageManager () {
     isInitialized = true;
@@ -42,7 +115,7 @@ RC createPageFile (char *fileName) {
 }
 
 RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
-    printf("Page file opening.\n");
+    TRACE_DEBUG(TE_OPEN_FILE, 0, 0);
     // Check for existence
     FILE *fileExists = fopen(fileName,"r");
     if (fileExists == NULL) {
@@ -57,6 +130,7 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
     fHandle->totalNumPages = 0;
     fHandle->curPagePos = 0;
     fHandle->mgmtInfo = NULL;
+    memset(&fHandle->ioStats, 0, sizeof(SM_FileIOStats));
 
     // Open the file
     fHandle->mgmtInfo = fopen(fileName, "r+");
@@ -85,7 +159,7 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
 }
 
 RC closePageFile (SM_FileHandle *fHandle) {
-    printf("Page file closing.\n");
+    TRACE_DEBUG(TE_CLOSE_FILE, 0, 0);
 
     // Check if file handle is initialized
     if (fHandle->mgmtInfo == NULL) {
@@ -118,24 +192,32 @@ RC destroyPageFile (char *fileName) {
 }
 
 RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
-    printf("Reading Blocks.\n");
+    TRACE_DEBUG(TE_READ_BLOCK, pageNum, 1);
     // Check the validation
-    if (pageNum < 0 || pageNum > fHandle->totalNumPages) {
+    if (pageNum >= 0 && pageNum >= fHandle->totalNumPages) {
+        refreshNumPages(fHandle);
+    }
+    if (pageNum < 0 || pageNum >= fHandle->totalNumPages) {
         return RC_READ_NON_EXISTING_PAGE;
     }
 
-    // Move the file pointer to the pageNum
-    if (fseek(fHandle->mgmtInfo, pageNum * PAGE_SIZE, SEEK_SET) != 0) {
-        fprintf(stderr, "Error: Unable to move the file pointer to the pageNum.\n");
-        return RC_READ_FAILED;
-    }
+    LATENCY_START(start);
+
+    // Drain stdio buffers so the positioned read sees every earlier write
+    fflush(fHandle->mgmtInfo);
 
     // Stores its content in the memory pointed to by the memPage page handle
-    fread(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
+    struct iovec iov = {memPage, PAGE_SIZE};
+    RC rc = transferPages(fHandle, &iov, 1, (off_t) pageNum * PAGE_SIZE, false);
+    if (rc != RC_OK) {
+        return rc;
+    }
 
     // Update current position
     fHandle->curPagePos = pageNum;
 
+    LATENCY_RECORD(LAT_READ_BLOCK, start);
+
     return RC_OK;
 }
 
@@ -212,27 +294,125 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
     return readBlock(fHandle->curPagePos, fHandle, memPage);
 }
 
+RC readBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    // Check validation
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    if (startPage >= 0 && numPages > 0 && startPage + numPages > fHandle->totalNumPages) {
+        refreshNumPages(fHandle);
+    }
+    if (startPage < 0 || numPages <= 0 || startPage + numPages > fHandle->totalNumPages) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+
+    TRACE_DEBUG(TE_READ_BLOCK, startPage, numPages);
+
+    // Drain stdio buffers so the positioned read sees every earlier write
+    fflush(fHandle->mgmtInfo);
+
+    struct iovec *iov = (struct iovec *) malloc(numPages * sizeof(struct iovec));
+    if (iov == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    for (int i = 0; i < numPages; i++) {
+        iov[i].iov_base = memPages[i];
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    // Read the whole run of pages with one vectored call
+    RC rc = transferPages(fHandle, iov, numPages, (off_t) startPage * PAGE_SIZE, false);
+    free(iov);
+    if (rc != RC_OK) {
+        return rc;
+    }
+
+    // Update current position
+    fHandle->curPagePos = startPage + numPages - 1;
+
+    return RC_OK;
+}
+
 RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+    TRACE_DEBUG(TE_WRITE_BLOCK, pageNum, 1);
     // Check validation
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
         return RC_FILE_HANDLE_NOT_INIT;
     }
 
+    if (pageNum >= 0 && pageNum > fHandle->totalNumPages) {
+        refreshNumPages(fHandle);
+    }
     if (pageNum < 0 || pageNum > fHandle->totalNumPages) {
         return RC_WRITE_FAILED;
     }
 
-    // Move the pointer to the target page
-    if (fseek(fHandle->mgmtInfo, pageNum *PAGE_SIZE, SEEK_SET) != 0) {
-        fprintf(stderr, "Error: Unable to move the file pointer to the pageNum.\n");
-        return RC_READ_FAILED;
-    }
+    LATENCY_START(start);
+
+    // Drain stdio buffers first so an older buffered write cannot land on top of this one
+    fflush(fHandle->mgmtInfo);
 
     // Write Content to the file
-    fwrite(memPage, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
+    struct iovec iov = {memPage, PAGE_SIZE};
+    RC rc = transferPages(fHandle, &iov, 1, (off_t) pageNum * PAGE_SIZE, true);
+    if (rc != RC_OK) {
+        return rc;
+    }
 
+    // Writing the page after the last one grows the file
+    if (pageNum == fHandle->totalNumPages) {
+        fHandle->totalNumPages++;
+        fHandle->ioStats.extensions++;
+    }
     fHandle->curPagePos = pageNum;
 
+    LATENCY_RECORD(LAT_WRITE_BLOCK, start);
+
+    return RC_OK;
+}
+
+RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages) {
+    // Check validation
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    if (startPage >= 0 && numPages > 0 && startPage > fHandle->totalNumPages) {
+        refreshNumPages(fHandle);
+    }
+    if (startPage < 0 || numPages <= 0 || startPage > fHandle->totalNumPages) {
+        return RC_WRITE_FAILED;
+    }
+
+    TRACE_DEBUG(TE_WRITE_BLOCK, startPage, numPages);
+
+    // Drain stdio buffers first so an older buffered write cannot land on top of this one
+    fflush(fHandle->mgmtInfo);
+
+    struct iovec *iov = (struct iovec *) malloc(numPages * sizeof(struct iovec));
+    if (iov == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
+    for (int i = 0; i < numPages; i++) {
+        iov[i].iov_base = memPages[i];
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    // Write the whole run of pages with one vectored call
+    RC rc = transferPages(fHandle, iov, numPages, (off_t) startPage * PAGE_SIZE, true);
+    free(iov);
+    if (rc != RC_OK) {
+        return rc;
+    }
+
+    // Writing past the end grows the file
+    if (startPage + numPages > fHandle->totalNumPages) {
+        fHandle->totalNumPages = startPage + numPages;
+        fHandle->ioStats.extensions++;
+    }
+    fHandle->curPagePos = startPage + numPages - 1;
+
     return RC_OK;
 }
 
@@ -253,29 +433,29 @@ RC appendEmptyBlock (SM_FileHandle *fHandle) {
         return RC_FILE_HANDLE_NOT_INIT;
     }
 
-    // Move the pointer to the end
-    if (fseek(fHandle->mgmtInfo, 0, SEEK_END) != 0) {
-        fprintf(stderr, "Error: Unable to move the file pointer to the pageNum.\n");
-        return RC_READ_FAILED;
-    };
+    // Another handle may have grown the file, append after its real end
+    refreshNumPages(fHandle);
 
     // Get zero bytes buffer
     SM_PageHandle zeroPg = (SM_PageHandle) calloc(PAGE_SIZE, sizeof(char));
+    if (zeroPg == NULL) {
+        return RC_MEMORY_ALLOCATION_FAIL;
+    }
 
     // Write the page to the file
-    size_t appendContent = fwrite(zeroPg, sizeof(char), PAGE_SIZE, fHandle->mgmtInfo);
+    struct iovec iov = {zeroPg, PAGE_SIZE};
+    RC rc = transferPages(fHandle, &iov, 1, (off_t) fHandle->totalNumPages * PAGE_SIZE, true);
+    free(zeroPg);
 
     // Check Errors
-    if (appendContent != PAGE_SIZE) {
-        free(zeroPg);
+    if (rc != RC_OK) {
         return RC_WRITE_FAILED;
     }
 
     // Update total number and position
     fHandle->totalNumPages++;
     fHandle->curPagePos = fHandle->totalNumPages - 1;
-
-    free(zeroPg);
+    fHandle->ioStats.extensions++;
 
     return RC_OK;
 }
@@ -286,6 +466,9 @@ RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle) {
         return RC_FILE_HANDLE_NOT_INIT;
     }
 
+    if (fHandle->totalNumPages < numberOfPages) {
+        refreshNumPages(fHandle);
+    }
     if (fHandle->totalNumPages < numberOfPages) {
         int increasePg = numberOfPages - fHandle->totalNumPages;
         for (int i = 0; i < increasePg; i++) {
@@ -296,4 +479,52 @@ RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle) {
         }
     }
     return RC_OK;
-}
\ No newline at end of file
+}
+
+/*
+ * Shortens a page file to its first numberOfPages pages. A file that is
+ * not longer is left as it is. Other handles on the same file keep their
+ * page count until they are truncated too.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_HANDLE_NOT_INIT for a handle that is not open,
+ *   RC_WRITE_FAILED if the file cannot be shortened.
+ */
+RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+
+    struct stat fileStat;
+    fflush(fHandle->mgmtInfo);
+    if (fstat(fileno(fHandle->mgmtInfo), &fileStat) != 0) {
+        return RC_WRITE_FAILED;
+    }
+    if (fileStat.st_size > (off_t) numberOfPages * PAGE_SIZE
+            && ftruncate(fileno(fHandle->mgmtInfo), (off_t) numberOfPages * PAGE_SIZE) != 0) {
+        return RC_WRITE_FAILED;
+    }
+
+    if (fHandle->totalNumPages > numberOfPages) {
+        fHandle->totalNumPages = numberOfPages;
+    }
+    if (fHandle->curPagePos >= numberOfPages) {
+        fHandle->curPagePos = numberOfPages - 1;
+    }
+    return RC_OK;
+}
+
+/*
+ * Copies the I/O counters of an open file handle: pages and bytes moved,
+ * read and write system calls, file extensions and time blocked in I/O.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_HANDLE_NOT_INIT for a handle that is not open.
+ */
+RC getFileIOStats (SM_FileHandle *fHandle, SM_FileIOStats *stats) {
+    if (fHandle == NULL || fHandle->mgmtInfo == NULL || stats == NULL) {
+        return RC_FILE_HANDLE_NOT_INIT;
+    }
+    *stats = fHandle->ioStats;
+    return RC_OK;
+}
@@ -6,11 +6,24 @@
 /************************************************************
  *                    handle data structures                *
  ************************************************************/
+// I/O issued through one file handle since it was opened
+typedef struct SM_FileIOStats {
+	long pagesRead;
+	long pagesWritten;
+	long bytesRead;
+	long bytesWritten;
+	long readCalls;     // read system calls
+	long writeCalls;    // write system calls
+	long extensions;    // times the file grew
+	long long ioNanos;  // time spent blocked in read and write calls
+} SM_FileIOStats;
+
 typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
 	void *mgmtInfo;
+	SM_FileIOStats ioStats;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
@@ -33,11 +46,17 @@ extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle);
+
+/* I/O accounting */
+extern RC getFileIOStats (SM_FileHandle *fHandle, SM_FileIOStats *stats);
 
 #endif
@@ -4,15 +4,28 @@
 #include "dt.h"
 #include "storage_mgr.h"
 #include "buffer_mgr.h"
+#include "fsm.h"
 
 // Data Types, Records, and Schemas
 typedef enum DataType {
 	DT_INT = 0,
 	DT_STRING = 1,
 	DT_FLOAT = 2,
-	DT_BOOL = 3
+	DT_BOOL = 3,
+	DT_VARCHAR = 4,  // string of at most typeLength bytes, stored with its length
+	DT_NULL = 5      // type of a NULL value, never of an attribute
 } DataType;
 
+// A DT_VARCHAR attribute takes typeLength bytes in Record.data, zero-padded
+// like DT_STRING, but only a length byte and its characters on the page
+#define VARCHAR_MAX_LENGTH 255
+
+// Record.data starts with a null bitmap, bit i (bit i % 8 of byte i / 8) set
+// while attribute i is NULL, followed by the attributes in schema order. A
+// NULL attribute's bytes are zero, and NULL attributes at the end of a
+// record are not stored on the page.
+#define NULL_BITMAP_SIZE(numAttr) (((numAttr) + 7) / 8)
+
 typedef struct Value {
 	DataType dt;
 	union v {
@@ -25,6 +38,7 @@ typedef struct Value {
 
 typedef struct SlotDirectoryEntry {
     int offset;
+    short length; // bytes of the record as stored on the page
     bool isFree;
 } SlotDirectoryEntry;
 
@@ -46,6 +60,12 @@ typedef struct PageDirectoryEntry {
     int recordCount; // currently record numbers
 } PageDirectoryEntry;
 
+// A page directory page starts with a header (numPages and numPageDP, only
+// meaningful in the first directory page) followed by the entries of the
+// data pages stored right after it in the file
+#define PAGE_DIRECTORY_HEADER_SIZE (2 * (int) sizeof(int))
+#define PAGE_DIRECTORY_ENTRIES ((PAGE_SIZE - PAGE_DIRECTORY_HEADER_SIZE) / (int) sizeof(PageDirectoryEntry))
+
 // information of the management data
 typedef struct RM_managementData
 {
@@ -56,9 +76,11 @@ typedef struct RM_managementData
     PageDirectoryEntry *pageDirectory; // Added field for page directory
     int numPages; // Added field for number of pages
     int numPageDP;
+    FreeSpaceMap freeSpace; // data pages by free space, rebuilt from the directory on open
 } RM_managementData;
 
-// information of a table schema: its attributes, datatypes, 
+// information of a table schema: its attributes, datatypes, and the record
+// layout that createSchema and openTable derive from them
 typedef struct Schema
 {
 	int numAttr;
@@ -67,6 +89,8 @@ typedef struct Schema
 	int *typeLength;
 	int *keyAttrs;
 	int keySize;
+	int *attrOffsets;   // offset of every attribute in Record.data, then the record size
+	bool fixedSize;     // no DT_VARCHAR attribute, so records are stored as Record.data
 } Schema;
 
 // TableData: Management Structure for a Record Manager to handle one relation
@@ -86,6 +110,13 @@ typedef struct RM_TableData
 		} while(0)
 
 
+#define MAKE_NULL_VALUE(result)						\
+		do {									\
+			(result) = (Value *) malloc(sizeof(Value));				\
+			(result)->dt = DT_NULL;						\
+		} while(0)
+
+
 #define MAKE_VALUE(result, datatype, value)				\
 		do {									\
 			(result) = (Value *) malloc(sizeof(Value));				\
@@ -1,8 +1,13 @@
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
 #include "tables.h"
+#include "latency.h"
+#include "loader.h"
+#include "metrics.h"
 #include "test_helper.h"
 
 
@@ -55,6 +60,30 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testResizeTablePool(void);
+static void testBatchPins(void);
+static void testGetRecords(void);
+static void testFlushSkipsPinned(void);
+static void testPoolStats(void);
+static void testPageTrace(void);
+static void testFileIOStats(void);
+static void testLatchProfiling(void);
+static void testLruKReplacement(void);
+static void testWarmRestart(void);
+static void testLruKWarmRestart(void);
+static void testLatencyHistograms(void);
+static void testMetricsSnapshot(void);
+static void testFreeSpaceReuse(void);
+static void testFreeSpaceClasses(void);
+static void testFreeSpaceLoad(void);
+static void testDirectoryPersistence(void);
+static void testBulkInsert(void);
+static void testLoadTable(void);
+static void testVarcharRecords(void);
+static void testNullValues(void);
+static void testSchemaLayout(void);
+static void testTypedAccessors(void);
+static void testVacuum(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -84,6 +113,30 @@ main (void)
     testScans();
     testScansTwo();
     testMultipleScans();
+    testResizeTablePool();
+    testBatchPins();
+    testGetRecords();
+    testFlushSkipsPinned();
+    testPoolStats();
+    testPageTrace();
+    testFileIOStats();
+    testLatchProfiling();
+    testLruKReplacement();
+    testWarmRestart();
+    testLruKWarmRestart();
+    testLatencyHistograms();
+    testMetricsSnapshot();
+    testFreeSpaceReuse();
+    testFreeSpaceClasses();
+    testFreeSpaceLoad();
+    testDirectoryPersistence();
+    testBulkInsert();
+    testLoadTable();
+    testVarcharRecords();
+    testNullValues();
+    testSchemaLayout();
+    testTypedAccessors();
+    testVacuum();
 
     return 0;
 }
@@ -304,6 +357,1523 @@ testMultipleScans(void)
     TEST_DONE();
 }
 
+void
+testResizeTablePool(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+            {1, "aaaa", 3},
+            {2, "bbbb", 2},
+            {3, "cccc", 1},
+            {4, "dddd", 3},
+            {5, "eeee", 5},
+            {6, "ffff", 1},
+            {7, "gggg", 3},
+            {8, "hhhh", 3},
+            {9, "iiii", 2},
+            {10, "jjjj", 5},
+    };
+    int numInserts = 10, i;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    RM_managementData *mgmt;
+    testName = "test resizing the buffer pool of an open table";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTableWithPoolSize(table, "test_table_r", 3));
+    mgmt = (RM_managementData *) table->managementData;
+    ASSERT_EQUALS_INT(3, mgmt->bm.numPages, "pool opened with requested size");
+
+    for(i = 0; i < numInserts; i++)
+    {
+        r = fromTestRecord(schema, inserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    // grow, then shrink below the number of resident pages
+    TEST_CHECK(resizeTablePool(table, 8));
+    ASSERT_EQUALS_INT(8, mgmt->bm.numPages, "pool grown");
+    TEST_CHECK(resizeTablePool(table, 1));
+    ASSERT_EQUALS_INT(1, mgmt->bm.numPages, "pool shrunk");
+    ASSERT_ERROR(resizeTablePool(table, 0), "pool size must be positive");
+
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++)
+    {
+        TEST_CHECK(getRecord(table, rids[i], r));
+        Record *expected = fromTestRecord(schema, inserts[i]);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records after resize");
+        freeRecord(expected);
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testBatchPins(void)
+{
+    BM_BufferPool bm;
+    BM_PageHandle handles[2], held;
+    PageNumber pages[] = { 1, 2 };
+    PageNumber *contents;
+    bool *dirty;
+    int *fixCounts;
+    int readIO;
+    void *file;
+    testName = "test pinning and unpinning pages in batches";
+
+    memset(handles, 0, sizeof(handles));
+    memset(&held, 0, sizeof(held));
+    TEST_CHECK(createPageFile("test_table_batch"));
+    TEST_CHECK(initBufferPool(&bm, "test_table_batch", 2, RS_LRU, NULL));
+
+    // a victim that cannot be written back stays resident and dirty, and the batch pins nothing
+    TEST_CHECK(pinPage(&bm, &handles[0], 0));
+    TEST_CHECK(markDirty(&bm, &handles[0]));
+    TEST_CHECK(unpinPage(&bm, &handles[0]));
+    file = bm.fileHandle.mgmtInfo;
+    bm.fileHandle.mgmtInfo = NULL;
+    ASSERT_ERROR(pinPages(&bm, handles, pages, 2), "victim write-back failed");
+    bm.fileHandle.mgmtInfo = file;
+    contents = getFrameContents(&bm);
+    dirty = getDirtyFlags(&bm);
+    fixCounts = getFixCounts(&bm);
+    ASSERT_TRUE(contents[0] == 0 && dirty[0], "victim kept resident and dirty");
+    ASSERT_TRUE(contents[1] == NO_PAGE, "page claimed by the failed batch released");
+    ASSERT_TRUE(fixCounts[0] == 0 && fixCounts[1] == 0, "no pins left behind");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(&bm), "no write counted for the failed write-back");
+    free(contents);
+    free(dirty);
+    free(fixCounts);
+
+    // once the write succeeds the same batch goes through
+    TEST_CHECK(pinPages(&bm, handles, pages, 2));
+    ASSERT_EQUALS_INT(1, getNumWriteIO(&bm), "victim written back");
+    TEST_CHECK(unpinPages(&bm, handles, 2));
+
+    // a page listed twice is read once and pinned twice
+    readIO = getNumReadIO(&bm);
+    pages[0] = 3;
+    pages[1] = 3;
+    TEST_CHECK(pinPages(&bm, handles, pages, 2));
+    ASSERT_TRUE(handles[0].data == handles[1].data, "both handles share one frame");
+    ASSERT_EQUALS_INT(readIO + 1, getNumReadIO(&bm), "duplicate page read once");
+    fixCounts = getFixCounts(&bm);
+    ASSERT_EQUALS_INT(2, fixCounts[handles[0].frameIndex], "duplicate page pinned twice");
+    free(fixCounts);
+    TEST_CHECK(unpinPages(&bm, handles, 2));
+    fixCounts = getFixCounts(&bm);
+    ASSERT_EQUALS_INT(0, fixCounts[handles[0].frameIndex], "both pins released");
+    free(fixCounts);
+
+    // running out of frames partway through releases the pins the batch already took
+    TEST_CHECK(pinPage(&bm, &held, 0));
+    readIO = getNumReadIO(&bm);
+    pages[0] = 4;
+    pages[1] = 5;
+    ASSERT_ERROR(pinPages(&bm, handles, pages, 2), "frames ran out mid-batch");
+    contents = getFrameContents(&bm);
+    fixCounts = getFixCounts(&bm);
+    ASSERT_TRUE(fixCounts[held.frameIndex] == 1 && fixCounts[1 - held.frameIndex] == 0, "only the held page stays pinned");
+    ASSERT_TRUE(contents[1 - held.frameIndex] == NO_PAGE, "page claimed by the failed batch released");
+    ASSERT_EQUALS_INT(readIO, getNumReadIO(&bm), "nothing read for the failed batch");
+    free(contents);
+    free(fixCounts);
+    TEST_CHECK(unpinPage(&bm, &held));
+
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile("test_table_batch"));
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testGetRecords(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+            {1, "aaaa", 3},
+            {2, "bbbb", 2},
+            {3, "cccc", 1},
+            {4, "dddd", 3},
+            {5, "eeee", 5},
+            {6, "ffff", 1},
+            {7, "gggg", 3},
+            {8, "hhhh", 3},
+            {9, "iiii", 2},
+            {10, "jjjj", 5},
+    };
+    int numInserts = 10, i;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    testName = "test retrieving records with one batched lookup";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    Record *fetched[numInserts];
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTableWithPoolSize(table, "test_table_r", 1));
+
+    for(i = 0; i < numInserts; i++)
+    {
+        r = fromTestRecord(schema, inserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    // a batch spanning two data pages cannot be pinned in a single frame
+    for(i = 0; i < numInserts; i++)
+        TEST_CHECK(createRecord(&fetched[i], schema));
+    ASSERT_ERROR(getRecords(table, rids, fetched, numInserts), "batch larger than the pool");
+
+    // records come back in the order of their ids, including one listed twice
+    TEST_CHECK(resizeTablePool(table, 4));
+    rids[numInserts - 1] = rids[0];
+    TEST_CHECK(getRecords(table, rids, fetched, numInserts));
+    for(i = 0; i < numInserts; i++)
+    {
+        Record *expected = fromTestRecord(schema, inserts[i == numInserts - 1 ? 0 : i]);
+        ASSERT_EQUALS_RECORDS(expected, fetched[i], schema, "compare batched records");
+        freeRecord(expected);
+        freeRecord(fetched[i]);
+    }
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testFlushSkipsPinned(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    Schema *schema;
+    RM_managementData *mgmt;
+    BM_PageHandle handle;
+    bool *dirty;
+    testName = "test flushing skips pinned pages";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // flushing skips pinned pages instead of giving up on the whole pool
+    memset(&handle, 0, sizeof(handle));
+    TEST_CHECK(pinPage(&mgmt->bm, &handle, 0));
+    TEST_CHECK(markDirty(&mgmt->bm, &handle));
+    TEST_CHECK(forceFlushPool(&mgmt->bm));
+    dirty = getDirtyFlags(&mgmt->bm);
+    ASSERT_TRUE(dirty[handle.frameIndex], "pinned page stays dirty");
+    free(dirty);
+    TEST_CHECK(unpinPage(&mgmt->bm, &handle));
+    TEST_CHECK(forceFlushPool(&mgmt->bm));
+    dirty = getDirtyFlags(&mgmt->bm);
+    ASSERT_TRUE(!dirty[handle.frameIndex], "unpinned page flushed");
+    free(dirty);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testPoolStats(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    Schema *schema;
+    RM_managementData *mgmt;
+    BM_PageHandle handle;
+    BM_Stats stats;
+    testName = "test per-pool buffer statistics";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // make the schema page resident, then count from a reset
+    memset(&handle, 0, sizeof(handle));
+    TEST_CHECK(pinPage(&mgmt->bm, &handle, 0));
+    TEST_CHECK(unpinPage(&mgmt->bm, &handle));
+    TEST_CHECK(resetBufferPoolStats(&mgmt->bm));
+    TEST_CHECK(pinPage(&mgmt->bm, &handle, 0));
+    TEST_CHECK(markDirty(&mgmt->bm, &handle));
+    TEST_CHECK(forcePage(&mgmt->bm, &handle));
+    ASSERT_ERROR(pinPage(&mgmt->bm, &handle, -1), "negative page number");
+    TEST_CHECK(getBufferPoolStats(&mgmt->bm, &stats));
+    ASSERT_EQUALS_INT(1, (int) stats.hits, "resident page pinned as a hit");
+    ASSERT_EQUALS_INT(0, (int) stats.misses, "no misses since reset");
+    ASSERT_EQUALS_INT(1, (int) stats.backgroundWritebacks, "forced page counted as background writeback");
+    ASSERT_EQUALS_INT(1, (int) stats.pinFailures, "failed pin counted");
+    ASSERT_EQUALS_INT(1, stats.peakPinnedFrames, "peak pinned frames");
+    TEST_CHECK(unpinPage(&mgmt->bm, &handle));
+    TEST_CHECK(getBufferPoolStats(&mgmt->bm, &stats));
+    ASSERT_EQUALS_INT(0, stats.pinnedFrames, "no frames pinned after unpin");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testPageTrace(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    Schema *schema;
+    RM_managementData *mgmt;
+    BM_PageHandle handle;
+    BM_TraceHeader traceHeader;
+    BM_TraceEvent traceEvents[3];
+    FILE *traceFile;
+    int headersRead, eventsRead;
+    testName = "test page reference tracing";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // pins and unpins are appended to the page reference trace
+    memset(&handle, 0, sizeof(handle));
+    TEST_CHECK(enablePageTrace(&mgmt->bm, "test_table_r.trace"));
+    TEST_CHECK(pinPage(&mgmt->bm, &handle, 0));
+    TEST_CHECK(markDirty(&mgmt->bm, &handle));
+    TEST_CHECK(unpinPage(&mgmt->bm, &handle));
+    TEST_CHECK(disablePageTrace(&mgmt->bm));
+    traceFile = fopen("test_table_r.trace", "rb");
+    ASSERT_TRUE(traceFile != NULL, "trace file written");
+    headersRead = (int) fread(&traceHeader, sizeof(traceHeader), 1, traceFile);
+    eventsRead = (int) fread(traceEvents, sizeof(BM_TraceEvent), 3, traceFile);
+    fclose(traceFile);
+    remove("test_table_r.trace");
+    ASSERT_EQUALS_INT(1, headersRead, "trace header read");
+    ASSERT_EQUALS_INT(2, eventsRead, "one event per pin and unpin");
+    ASSERT_EQUALS_INT(BM_TRACE_MAGIC, (int) traceHeader.magic, "trace magic");
+    ASSERT_EQUALS_INT(BM_TRACE_PIN, traceEvents[0].kind, "first event is the pin");
+    ASSERT_EQUALS_INT(BM_TRACE_UNPIN, traceEvents[1].kind, "second event is the unpin");
+    ASSERT_EQUALS_INT(0, traceEvents[1].pageNum, "traced page number");
+    ASSERT_EQUALS_INT(1, traceEvents[1].dirty, "unpin of a modified page is dirty");
+    ASSERT_TRUE(traceEvents[1].timestamp >= traceEvents[0].timestamp, "timestamps are monotonic");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testFileIOStats(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord insert = {1, "aaaa", 3};
+    Record *r;
+    Schema *schema;
+    RM_managementData *mgmt;
+    BM_PageHandle handle;
+    SM_FileIOStats ioBefore, ioAfter;
+    testName = "test I/O accounting per file handle";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // the pool and the table each account the I/O of their own file handle
+    memset(&handle, 0, sizeof(handle));
+    TEST_CHECK(getFileIOStats(&mgmt->bm.fileHandle, &ioBefore));
+    TEST_CHECK(pinPage(&mgmt->bm, &handle, 0));
+    TEST_CHECK(markDirty(&mgmt->bm, &handle));
+    TEST_CHECK(forcePage(&mgmt->bm, &handle));
+    TEST_CHECK(unpinPage(&mgmt->bm, &handle));
+    TEST_CHECK(getFileIOStats(&mgmt->bm.fileHandle, &ioAfter));
+    ASSERT_EQUALS_INT(1, (int) (ioAfter.pagesWritten - ioBefore.pagesWritten), "forced page written once");
+    ASSERT_EQUALS_INT(1, (int) (ioAfter.writeCalls - ioBefore.writeCalls), "one write call per page");
+    ASSERT_EQUALS_INT(PAGE_SIZE, (int) (ioAfter.bytesWritten - ioBefore.bytesWritten), "bytes written");
+    TEST_CHECK(getFileIOStats(&mgmt->fileHndl, &ioBefore));
+    r = fromTestRecord(schema, insert);
+    TEST_CHECK(insertRecord(table, r));
+    freeRecord(r);
+    TEST_CHECK(getFileIOStats(&mgmt->fileHndl, &ioAfter));
+    ASSERT_EQUALS_INT(0, (int) (ioAfter.pagesWritten - ioBefore.pagesWritten), "inserts leave writing to the pool");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testLatchProfiling(void)
+{
+    testName = "test latch contention profiling";
+#if LATCH_PROFILING
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    Schema *schema;
+    RM_managementData *mgmt;
+    BM_PageHandle handle;
+    LatchStats latchStats;
+    char latchName[LATCH_NAME_LENGTH];
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // frame latches are profiled under their frame name
+    memset(&handle, 0, sizeof(handle));
+    resetLatchStats();
+    TEST_CHECK(pinPage(&mgmt->bm, &handle, 0));
+    TEST_CHECK(forcePage(&mgmt->bm, &handle));
+    TEST_CHECK(unpinPage(&mgmt->bm, &handle));
+    snprintf(latchName, sizeof(latchName), "pool frame %d", handle.frameIndex);
+    TEST_CHECK(getLatchStats(latchName, &latchStats));
+    ASSERT_EQUALS_INT(1, (int) latchStats.acquisitions, "forcePage latched the frame once");
+    ASSERT_EQUALS_INT(0, (int) latchStats.contended, "single thread never waits");
+    ASSERT_ERROR(getLatchStats("no such latch", &latchStats), "unknown latch name");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+#endif
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testLruKReplacement(void)
+{
+    BM_BufferPool bm;
+    BM_PageHandle handle, held;
+    PageNumber *contents;
+    int k = 2;
+    testName = "test LRU-K evicts by backward K-distance";
+
+    memset(&handle, 0, sizeof(handle));
+    memset(&held, 0, sizeof(held));
+    TEST_CHECK(createPageFile("test_table_lruk"));
+    TEST_CHECK(initBufferPool(&bm, "test_table_lruk", 2, RS_LRU_K, &k));
+
+    // page 1 is the most recently used, but page 0's second to last pin is older
+    TEST_CHECK(pinPage(&bm, &handle, 0));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 1));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 1));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 0));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 2));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    contents = getFrameContents(&bm);
+    ASSERT_TRUE(contents[0] == 2 && contents[1] == 1, "page with the oldest second to last pin evicted");
+    free(contents);
+
+    // a page pinned once goes before pages pinned twice, and pinned pages are never evicted
+    TEST_CHECK(pinPage(&bm, &held, 1));
+    TEST_CHECK(pinPage(&bm, &handle, 3));
+    contents = getFrameContents(&bm);
+    ASSERT_TRUE(contents[0] == 3 && contents[1] == 1, "page pinned once evicted, pinned page kept");
+    free(contents);
+    ASSERT_ERROR(pinPage(&bm, &handle, 4), "every frame pinned");
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(unpinPage(&bm, &held));
+
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile("test_table_lruk"));
+    TEST_DONE();
+}
+
+void
+testWarmRestart(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+            {1, "aaaa", 3},
+            {2, "bbbb", 2},
+            {3, "cccc", 1},
+    };
+    int numInserts = 3, i, readIO;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    RM_managementData *mgmt;
+    FILE *snapshot;
+    testName = "test warm restart from a residency snapshot";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+
+    for(i = 0; i < numInserts; i++)
+    {
+        r = fromTestRecord(schema, inserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    mgmt = (RM_managementData *) table->managementData;
+    TEST_CHECK(enableResidencySnapshot(&mgmt->bm, true));
+    TEST_CHECK(closeTable(table));
+
+    snapshot = fopen("test_table_r.bpsnap", "rb");
+    ASSERT_TRUE(snapshot != NULL, "snapshot written on shutdown");
+    fclose(snapshot);
+
+    // the data page is reloaded while opening, so reading it costs no I/O
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+    snapshot = fopen("test_table_r.bpsnap", "rb");
+    ASSERT_TRUE(snapshot == NULL, "snapshot consumed on init");
+
+    readIO = getNumReadIO(&mgmt->bm);
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++)
+    {
+        TEST_CHECK(getRecord(table, rids[i], r));
+        Record *expected = fromTestRecord(schema, inserts[i]);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records after warm restart");
+        freeRecord(expected);
+    }
+    freeRecord(r);
+    ASSERT_EQUALS_INT(readIO, getNumReadIO(&mgmt->bm), "no reads after warm restart");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testLruKWarmRestart(void)
+{
+    BM_BufferPool bm;
+    BM_PageHandle handle;
+    PageNumber *contents;
+    int k = 2, readIO;
+    testName = "test LRU-K history survives a warm restart";
+
+    memset(&handle, 0, sizeof(handle));
+    TEST_CHECK(createPageFile("test_table_lruk"));
+    TEST_CHECK(initBufferPool(&bm, "test_table_lruk", 2, RS_LRU_K, &k));
+
+    // page 1 is the most recently used, but page 0's second to last pin is newer
+    TEST_CHECK(pinPage(&bm, &handle, 1));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 0));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 0));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(pinPage(&bm, &handle, 1));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    TEST_CHECK(enableResidencySnapshot(&bm, true));
+    TEST_CHECK(shutdownBufferPool(&bm));
+
+    // both pages come back with their pin history, so page 1 is still the victim
+    TEST_CHECK(initBufferPool(&bm, "test_table_lruk", 2, RS_LRU_K, &k));
+    readIO = getNumReadIO(&bm);
+    ASSERT_EQUALS_INT(2, readIO, "both pages reloaded");
+    TEST_CHECK(pinPage(&bm, &handle, 2));
+    TEST_CHECK(unpinPage(&bm, &handle));
+    contents = getFrameContents(&bm);
+    ASSERT_TRUE(contents[0] == 0 && contents[1] == 2, "page with the oldest second to last pin evicted");
+    free(contents);
+    ASSERT_EQUALS_INT(readIO + 1, getNumReadIO(&bm), "only the new page read");
+
+    TEST_CHECK(shutdownBufferPool(&bm));
+    TEST_CHECK(destroyPageFile("test_table_lruk"));
+    TEST_DONE();
+}
+
+void
+testLatencyHistograms(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+            {1, "aaaa", 3},
+            {2, "bbbb", 2},
+            {3, "cccc", 1},
+            {4, "dddd", 3},
+            {5, "eeee", 5},
+    };
+    int numInserts = 5, numLookups = 1000, i;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    testName = "test latency histograms of record operations";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    latencyReset();
+
+    for(i = 0; i < numInserts; i++)
+    {
+        r = fromTestRecord(schema, inserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    createRecord(&r, schema);
+    for(i = 0; i < numLookups; i++)
+        TEST_CHECK(getRecord(table, rids[i % numInserts], r));
+    freeRecord(r);
+
+#if LATENCY_HISTOGRAMS
+    // every insert and lookup left one latency sample
+    LatencyHistogram histogram;
+    TEST_CHECK(latencySnapshot(LAT_INSERT_RECORD, &histogram));
+    ASSERT_EQUALS_INT(numInserts, (int) histogram.count, "one insertRecord sample per insert");
+    TEST_CHECK(latencySnapshot(LAT_GET_RECORD, &histogram));
+    ASSERT_EQUALS_INT(numLookups, (int) histogram.count, "one getRecord sample per lookup");
+    ASSERT_TRUE(latencyPercentile(&histogram, 50.0) <= latencyPercentile(&histogram, 99.9),
+            "median not above the tail");
+    ASSERT_TRUE(latencyPercentile(&histogram, 99.9) <= histogram.max, "tail capped at the maximum");
+#endif
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testMetricsSnapshot(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    TestRecord inserts[] = {
+            {1, "aaaa", 3},
+            {2, "bbbb", 2},
+            {3, "cccc", 1},
+    };
+    int numInserts = 3, i, lines = 0;
+    char line[8192];
+    Record *r;
+    Schema *schema;
+    FILE *out;
+    testName = "test metrics snapshots of a watched table";
+    schema = testSchema();
+    remove("test_metrics.jsonl");
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    for(i = 0; i < numInserts; i++)
+    {
+        r = fromTestRecord(schema, inserts[i]);
+        TEST_CHECK(insertRecord(table,r));
+        freeRecord(r);
+    }
+    TEST_CHECK(metricsWatchTable(table));
+
+    out = fopen("test_metrics.jsonl", "w");
+    TEST_CHECK(writeMetricsSnapshot(out));
+    fclose(out);
+    out = fopen("test_metrics.jsonl", "r");
+    ASSERT_TRUE(fgets(line, sizeof(line), out) != NULL, "snapshot line written");
+    fclose(out);
+    ASSERT_TRUE(strstr(line, "\"name\": \"test_table_r\"") != NULL, "table in snapshot");
+    ASSERT_TRUE(strstr(line, "\"tuples\": 3") != NULL, "tuple count in snapshot");
+    ASSERT_TRUE(strstr(line, "\"file\": \"test_table_r\"") != NULL, "table pool in snapshot");
+
+    // the reporter appends a line per interval and a last one when stopped
+    TEST_CHECK(startMetricsReporter("test_metrics.jsonl", 5));
+    usleep(50000);
+    TEST_CHECK(stopMetricsReporter());
+    out = fopen("test_metrics.jsonl", "r");
+    while (fgets(line, sizeof(line), out) != NULL)
+        lines++;
+    fclose(out);
+    ASSERT_TRUE(lines >= 3, "reporter appended snapshots");
+
+    // a closed table is no longer sampled
+    TEST_CHECK(closeTable(table));
+    out = fopen("test_metrics.jsonl", "w");
+    TEST_CHECK(writeMetricsSnapshot(out));
+    fclose(out);
+    out = fopen("test_metrics.jsonl", "r");
+    ASSERT_TRUE(fgets(line, sizeof(line), out) != NULL, "snapshot line written");
+    fclose(out);
+    ASSERT_TRUE(strstr(line, "\"pools\": [], \"tables\": []") != NULL, "closed table forgotten");
+
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+    remove("test_metrics.jsonl");
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testFreeSpaceReuse(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 15, i;
+    char b[5];
+    Record *r, *expected;
+    RID *rids;
+    Schema *schema;
+    testName = "test inserts reuse space freed by deletes";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+
+    // fill a few data pages, then free two slots on the first page; one freed
+    // record alone leaves less room than a record and a new slot need
+    for(i = 0; i < numInserts; i++)
+    {
+        sprintf(b, "r%03d", i);
+        r = testRecord(schema, i, b, i * 2);
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    ASSERT_TRUE(rids[numInserts - 1].page > 0, "records span several pages");
+    TEST_CHECK(deleteRecord(table, rids[1]));
+    TEST_CHECK(deleteRecord(table, rids[2]));
+
+    // the next insert lands in the freed slot instead of the last page
+    r = testRecord(schema, 100, "new0", 200);
+    TEST_CHECK(insertRecord(table,r));
+    ASSERT_EQUALS_INT(rids[1].page, r->id.page, "insert reuses the page with a free slot");
+    ASSERT_EQUALS_INT(rids[1].slot, r->id.slot, "insert reuses the freed slot");
+    rids[1] = r->id;
+    freeRecord(r);
+
+    // no other record was overwritten
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++)
+    {
+        if (i == 2)
+            continue;
+        TEST_CHECK(getRecord(table, rids[i], r));
+        sprintf(b, "r%03d", i);
+        expected = i == 1 ? testRecord(schema, 100, "new0", 200) : testRecord(schema, i, b, i * 2);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records after slot reuse");
+        freeRecord(expected);
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(rids);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testFreeSpaceClasses(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    char *names[] = { "a" };
+    DataType dt[] = { DT_STRING };
+    int sizes[] = { PAGE_SIZE - (int) sizeof(SlotDirectoryEntry) - 2 };
+    int keys[] = {0};
+    char b[PAGE_SIZE];
+    FreeSpaceMap fsm;
+    Record *r;
+    Value *value;
+    RID first;
+    Schema *schema;
+    RM_managementData *mgmt;
+    testName = "test free-space map classes";
+
+    // the page with the fewest free bytes that still has room is taken
+    fsmInit(&fsm);
+    TEST_CHECK(fsmSetFreeSpace(&fsm, 0, 40));
+    TEST_CHECK(fsmSetFreeSpace(&fsm, 1, 41));
+    TEST_CHECK(fsmSetFreeSpace(&fsm, 2, 90));
+    ASSERT_EQUALS_INT(1, fsmFindPage(&fsm, 41), "page with exactly enough room");
+    ASSERT_EQUALS_INT(2, fsmFindPage(&fsm, 42), "next page with room");
+    ASSERT_EQUALS_INT(41, fsmGetFreeSpace(&fsm, 1), "free space of one page");
+    ASSERT_EQUALS_INT(40 + 41 + 90, (int) fsm.totalFree, "free space of all pages");
+    ASSERT_EQUALS_INT(FSM_NO_PAGE, fsmFindPage(&fsm, PAGE_SIZE), "no page has a whole page free");
+    TEST_CHECK(fsmSetFreeSpace(&fsm, 0, PAGE_SIZE));
+    ASSERT_EQUALS_INT(0, fsmFindPage(&fsm, PAGE_SIZE), "empty page in the last class");
+    ASSERT_EQUALS_INT(PAGE_SIZE + 41 + 90, (int) fsm.totalFree, "total follows a page's update");
+    fsmFree(&fsm);
+
+    // records needing almost a whole page go to empty pages
+    schema = createSchema(1, names, dt, sizes, 1, keys);
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+    memset(b, 'x', sizes[0]);
+    b[sizes[0]] = '\0';
+    createRecord(&r, schema);
+    MAKE_STRING_VALUE(value, b);
+    TEST_CHECK(setAttr(r, schema, 0, value));
+    freeVal(value);
+    TEST_CHECK(insertRecord(table, r));
+    first = r->id;
+    TEST_CHECK(insertRecord(table, r));
+    ASSERT_TRUE(r->id.page != first.page, "one record per page");
+
+    // once the first page is empty again, the next insert reuses it
+    TEST_CHECK(deleteRecord(table, first));
+    TEST_CHECK(vacuumTable(table, NULL, NULL, NULL));
+    TEST_CHECK(insertRecord(table, r));
+    ASSERT_EQUALS_INT(first.page, r->id.page, "insert reuses the emptied page");
+    ASSERT_EQUALS_INT(2, mgmt->numPages - mgmt->numPageDP + 1, "no page added");
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testFreeSpaceLoad(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    char *names[] = { "a", "b" };
+    DataType dt[] = { DT_INT, DT_STRING };
+    int sizes[] = { 0, 30 };
+    int keys[] = {0};
+    int numInserts = 6000, numLookups = 20000, i, found = 0;
+    Record *r;
+    Value *value;
+    Schema *schema;
+    RM_managementData *mgmt;
+    FreeSpaceMap small;
+    struct timespec start, end;
+    double loadedSeconds, smallSeconds;
+    testName = "test free-space lookups stay constant time as a table grows";
+    schema = createSchema(2, names, dt, sizes, 1, keys);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // a stored record and its slot take 43 bytes, so every full page keeps 42
+    // free bytes and all of them share one free-space class
+    createRecord(&r, schema);
+    MAKE_STRING_VALUE(value, "abcdefghijklmnopqrstuvwxyzabcd");
+    TEST_CHECK(setAttr(r, schema, 1, value));
+    freeVal(value);
+    for (i = 0; i < numInserts; i++)
+    {
+        MAKE_VALUE(value, DT_INT, i);
+        TEST_CHECK(setAttr(r, schema, 0, value));
+        freeVal(value);
+        TEST_CHECK(insertRecord(table, r));
+    }
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "every row inserted");
+    ASSERT_TRUE(mgmt->freeSpace.numPages >= numInserts / 3, "thousands of full pages");
+
+    // a lookup that no full page satisfies costs the same with thousands of
+    // full pages as with one
+    fsmInit(&small);
+    TEST_CHECK(fsmSetFreeSpace(&small, 0, 42));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < numLookups; i++)
+        found += fsmFindPage(&small, 43 + i % 2) != FSM_NO_PAGE;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    smallSeconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fsmFree(&small);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < numLookups; i++)
+        found += fsmFindPage(&mgmt->freeSpace, 43 + i % 2) != FSM_NO_PAGE;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    loadedSeconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    ASSERT_TRUE(found <= numLookups, "lookups answered");
+    ASSERT_TRUE(loadedSeconds < 20 * smallSeconds + 0.002, "lookup time independent of the number of full pages");
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testDirectoryPersistence(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 100, i, rows = 0;
+    char b[5];
+    Record *r, *expected;
+    RID *rids;
+    Schema *schema;
+    RM_managementData *mgmt;
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    SM_FileIOStats ioBefore, ioAfter;
+    testName = "test page directory spanning several directory pages";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    for(i = 0; i < numInserts; i++)
+    {
+        sprintf(b, "d%03d", i);
+        r = testRecord(schema, i, b, i * 3);
+        if (i == numInserts - 1)
+            TEST_CHECK(getFileIOStats(&mgmt->fileHndl, &ioBefore));
+        TEST_CHECK(insertRecord(table,r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    TEST_CHECK(getFileIOStats(&mgmt->fileHndl, &ioAfter));
+    ASSERT_TRUE(mgmt->numPageDP > 1, "directory spans several pages");
+    ASSERT_EQUALS_INT(0, (int) (ioAfter.pagesWritten - ioBefore.pagesWritten), "no page written through on insert");
+    TEST_CHECK(checkpointTable(table));
+    TEST_CHECK(closeTable(table));
+
+    // every record is found at its RID after reopening
+    TEST_CHECK(openTable(table, "test_table_r"));
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "tuple count after reopen");
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++)
+    {
+        TEST_CHECK(getRecord(table, rids[i], r));
+        sprintf(b, "d%03d", i);
+        expected = testRecord(schema, i, b, i * 3);
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records after reopen");
+        freeRecord(expected);
+    }
+
+    TEST_CHECK(startScan(table, sc, NULL));
+    while(next(sc, r) == RC_OK)
+        rows++;
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts, rows, "scan sees every record");
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(schema);
+    free(rids);
+    free(sc);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testBulkInsert(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 60, i;
+    char b[5];
+    Record **records, *r;
+    Schema *schema;
+    RM_managementData *mgmt;
+    BM_Stats before, after;
+    testName = "test bulk insert with insertRecords";
+    schema = testSchema();
+    records = (Record **) malloc(sizeof(Record *) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    for(i = 0; i < numInserts; i++)
+    {
+        sprintf(b, "b%03d", i);
+        records[i] = testRecord(schema, i, b, -i);
+    }
+    TEST_CHECK(getBufferPoolStats(&mgmt->bm, &before));
+    TEST_CHECK(insertRecords(table, records, numInserts));
+    TEST_CHECK(getBufferPoolStats(&mgmt->bm, &after));
+
+    // a page and its directory page are pinned once per filled page, not per record
+    ASSERT_TRUE((after.hits + after.misses) - (before.hits + before.misses) < numInserts, "one pin per page");
+    ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "tuple count after bulk insert");
+    for(i = 1; i < numInserts; i++)
+        ASSERT_TRUE(records[i]->id.page > records[i - 1]->id.page
+                    || (records[i]->id.page == records[i - 1]->id.page && records[i]->id.slot > records[i - 1]->id.slot),
+                    "RIDs assigned in order");
+
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++)
+    {
+        TEST_CHECK(getRecord(table, records[i]->id, r));
+        ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare bulk inserted records");
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    for(i = 0; i < numInserts; i++)
+        freeRecord(records[i]);
+    freeSchema(schema);
+    free(records);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testLoadTable(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numCsv = 20, numRows = 50, i;
+    long loaded;
+    char b[5];
+    Record **records, *r;
+    Schema *schema;
+    FILE *file;
+    testName = "test direct-path load from CSV and binary rows";
+    schema = testSchema();
+    records = (Record **) malloc(sizeof(Record *) * numRows);
+    for(i = 0; i < numRows; i++)
+    {
+        sprintf(b, "b%03d", i);
+        records[i] = testRecord(schema, i, b, -i);
+    }
+
+    // the first rows as CSV with a header, the rest as raw row images
+    file = fopen("test_load.csv", "w");
+    fprintf(file, "a,b,c\n");
+    for(i = 0; i < numCsv; i++)
+        fprintf(file, "%d,b%03d,%d\n", i, i, -i);
+    fclose(file);
+    file = fopen("test_load.bin", "wb");
+    for(i = numCsv; i < numRows; i++)
+        fwrite(records[i]->data, getRecordSize(schema), 1, file);
+    fclose(file);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(loadTableFromCsv("test_table_r", "test_load.csv", TRUE, &loaded));
+    ASSERT_EQUALS_INT(numCsv, (int) loaded, "rows loaded from CSV");
+    TEST_CHECK(loadTableFromBinary("test_table_r", "test_load.bin", &loaded));
+    ASSERT_EQUALS_INT(numRows - numCsv, (int) loaded, "rows appended from the binary file");
+
+    // the rows come back in load order from fully packed pages
+    TEST_CHECK(openTable(table, "test_table_r"));
+    ASSERT_EQUALS_INT(numRows, getNumTuples(table), "tuple count after load");
+    createRecord(&r, schema);
+    TEST_CHECK(startScan(table, sc, NULL));
+    for(i = 0; next(sc, r) == RC_OK; i++)
+        ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare loaded records");
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numRows, i, "rows scanned after load");
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+    unlink("test_load.csv");
+    unlink("test_load.bin");
+
+    for(i = 0; i < numRows; i++)
+        freeRecord(records[i]);
+    freeSchema(schema);
+    free(records);
+    free(sc);
+    free(table);
+    TEST_DONE();
+}
+
+void
+testVarcharRecords(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    char *names[] = { "a", "b", "c" };
+    DataType dt[] = { DT_INT, DT_VARCHAR, DT_INT };
+    int sizes[] = { 0, 40, 0 };
+    int keys[] = {0};
+    int numInserts = 12, i;
+    char b[41];
+    Record **records, *r;
+    Schema *schema;
+    RM_managementData *mgmt;
+    RID grown;
+    testName = "test varchar records on slotted pages";
+    schema = createSchema(3, names, dt, sizes, 1, keys);
+    records = (Record **) malloc(sizeof(Record *) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+    for(i = 0; i < numInserts; i++)
+    {
+        sprintf(b, "v%d", i);
+        records[i] = testRecord(schema, i, b, -i);
+        TEST_CHECK(insertRecord(table, records[i]));
+    }
+
+    // short strings are stored at their length, so 12 rows take 2 pages instead of 6
+    ASSERT_EQUALS_INT(2, mgmt->numPages - mgmt->numPageDP + 1, "pages of packed records");
+
+    // a record growing within the free bytes of its page keeps its RID
+    grown = records[1]->id;
+    freeRecord(records[1]);
+    records[1] = testRecord(schema, 1, "ten chars!", -1);
+    records[1]->id = grown;
+    TEST_CHECK(updateRecord(table, records[1]));
+    ASSERT_TRUE(records[1]->id.page == grown.page && records[1]->id.slot == grown.slot, "grown record keeps its RID");
+
+    // one that no longer fits moves to another page
+    grown = records[2]->id;
+    freeRecord(records[2]);
+    records[2] = testRecord(schema, 2, "a string that fills forty characters ...", -2);
+    records[2]->id = grown;
+    TEST_CHECK(updateRecord(table, records[2]));
+    ASSERT_TRUE(records[2]->id.page != grown.page, "record too large for its page moves");
+
+    // every record reads back unchanged, also after reopening the table
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    createRecord(&r, schema);
+    for(i = 0; i < numInserts; i++)
+    {
+        TEST_CHECK(getRecord(table, records[i]->id, r));
+        ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare varchar records");
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    for(i = 0; i < numInserts; i++)
+        freeRecord(records[i]);
+    freeSchema(schema);
+    free(records);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testNullValues(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 42, i, nullPages, fullPages, scanned;
+    Record **records, *r;
+    Schema *schema;
+    RM_managementData *mgmt;
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    Expr *attr, *cons, *sel;
+    Value *value, *nullValue;
+    RC rc;
+    testName = "test NULL attributes in the null bitmap";
+    schema = testSchema();
+    records = (Record **) malloc(sizeof(Record *) * numInserts);
+    MAKE_NULL_VALUE(nullValue);
+
+    // a NULL reads back as DT_NULL until the attribute is set again
+    r = testRecord(schema, 1, "aaaa", 3);
+    TEST_CHECK(setAttr(r, schema, 1, nullValue));
+    ASSERT_TRUE(isAttrNull(r, schema, 1) && !isAttrNull(r, schema, 2), "only the attribute set to NULL is NULL");
+    TEST_CHECK(getAttr(r, schema, 1, &value));
+    ASSERT_TRUE(value->dt == DT_NULL, "getAttr of a NULL attribute");
+    freeVal(value);
+    MAKE_STRING_VALUE(value, "bbbb");
+    TEST_CHECK(setAttr(r, schema, 1, value));
+    freeVal(value);
+    ASSERT_TRUE(!isAttrNull(r, schema, 1), "setting a value clears the null bit");
+    freeRecord(r);
+
+    // rows whose last attribute is NULL are stored without it
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+    for(i = 0; i < numInserts; i++)
+    {
+        records[i] = testRecord(schema, i, "cccc", i);
+        TEST_CHECK(setAttr(records[i], schema, 2, nullValue));
+        if (i % 3 == 0)
+            TEST_CHECK(setAttr(records[i], schema, 1, nullValue));
+        TEST_CHECK(insertRecord(table, records[i]));
+    }
+    nullPages = mgmt->numPages - mgmt->numPageDP + 1;
+
+    // IS NULL tests the bitmap; a comparison with NULL is never true
+    MAKE_ATTRREF(attr, 1);
+    MAKE_UNOP_EXPR(sel, attr, OP_IS_NULL);
+    createRecord(&r, schema);
+    TEST_CHECK(startScan(table, sc, sel));
+    for (scanned = 0; (rc = next(sc, r)) == RC_OK; scanned++)
+        ASSERT_TRUE(isAttrNull(r, schema, 1), "scanned record has a NULL");
+    ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ends");
+    ASSERT_EQUALS_INT(numInserts / 3, scanned, "IS NULL matches the rows with a NULL");
+    TEST_CHECK(closeScan(sc));
+    freeExpr(sel);
+
+    MAKE_ATTRREF(attr, 2);
+    MAKE_CONS(cons, stringToValue("i3"));
+    MAKE_BINOP_EXPR(sel, attr, cons, OP_COMP_EQUAL);
+    TEST_CHECK(startScan(table, sc, sel));
+    ASSERT_TRUE(next(sc, r) == RC_RM_NO_MORE_TUPLES, "NULL = 3 is not true");
+    TEST_CHECK(closeScan(sc));
+    freeExpr(sel);
+
+    // NULLs read back after reopening the table
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    for(i = 0; i < numInserts; i++)
+    {
+        TEST_CHECK(getRecord(table, records[i]->id, r));
+        ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare records with NULLs");
+    }
+    freeRecord(r);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+
+    // the same rows without NULLs take more pages
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+    for(i = 0; i < numInserts; i++)
+    {
+        r = testRecord(schema, i, "cccc", i);
+        TEST_CHECK(insertRecord(table, r));
+        freeRecord(r);
+    }
+    fullPages = mgmt->numPages - mgmt->numPageDP + 1;
+    ASSERT_TRUE(nullPages < fullPages, "trailing NULLs are not stored");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    for(i = 0; i < numInserts; i++)
+        freeRecord(records[i]);
+    freeVal(nullValue);
+    freeSchema(schema);
+    free(records);
+    free(sc);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testSchemaLayout(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    char *names[] = { "a", "b", "c", "d", "e" };
+    DataType dt[] = { DT_INT, DT_STRING, DT_BOOL, DT_VARCHAR, DT_FLOAT };
+    int sizes[] = { 0, 4, 0, 10, 0 };
+    int keys[] = {0};
+    int offsets[] = { 1, 5, 9, 9 + sizeof(bool), 19 + sizeof(bool), 23 + sizeof(bool) };
+    Schema *schema, *fixed;
+    int i;
+    testName = "test precomputed attribute offsets";
+    schema = createSchema(5, names, dt, sizes, 1, keys);
+    fixed = testSchema();
+
+    // attributes follow the one byte null bitmap; the last offset is the record size
+    for (i = 0; i <= 5; i++)
+        ASSERT_EQUALS_INT(offsets[i], schema->attrOffsets[i], "attribute offset");
+    ASSERT_EQUALS_INT(offsets[5], getRecordSize(schema), "record size");
+    ASSERT_TRUE(!schema->fixedSize && fixed->fixedSize, "only a schema with a varchar is not fixed size");
+
+    // openTable lays out the schema it reads like createSchema does
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    for (i = 0; i <= 5; i++)
+        ASSERT_EQUALS_INT(offsets[i], table->schema->attrOffsets[i], "attribute offset after openTable");
+    ASSERT_TRUE(!table->schema->fixedSize, "fixed size flag after openTable");
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeSchema(fixed);
+    freeSchema(schema);
+    free(table);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testTypedAccessors(void)
+{
+    char *names[] = { "a", "b", "c", "d", "e" };
+    DataType dt[] = { DT_INT, DT_STRING, DT_BOOL, DT_VARCHAR, DT_FLOAT };
+    int sizes[] = { 0, 4, 0, 10, 0 };
+    int keys[] = {0};
+    Schema *schema;
+    Record *r;
+    Value *value;
+    const char *chars;
+    int intV, length;
+    float floatV;
+    bool boolV;
+    testName = "test typed attribute accessors";
+    schema = createSchema(5, names, dt, sizes, 1, keys);
+    TEST_CHECK(createRecord(&r, schema));
+
+    MAKE_VALUE(value, DT_INT, 42);
+    TEST_CHECK(setAttr(r, schema, 0, value));
+    freeVal(value);
+    MAKE_STRING_VALUE(value, "abcd");
+    TEST_CHECK(setAttr(r, schema, 1, value));
+    freeVal(value);
+    MAKE_VALUE(value, DT_BOOL, TRUE);
+    TEST_CHECK(setAttr(r, schema, 2, value));
+    freeVal(value);
+    MAKE_STRING_VALUE(value, "xyz");
+    TEST_CHECK(setAttr(r, schema, 3, value));
+    freeVal(value);
+    MAKE_NULL_VALUE(value);
+    TEST_CHECK(setAttr(r, schema, 4, value));
+    freeVal(value);
+
+    TEST_CHECK(getIntAttr(r, schema, 0, &intV));
+    ASSERT_EQUALS_INT(42, intV, "int attribute");
+    TEST_CHECK(getBoolAttr(r, schema, 2, &boolV));
+    ASSERT_TRUE(boolV == TRUE, "bool attribute");
+
+    // string views point into the record, with the length of the string
+    TEST_CHECK(getStringAttrView(r, schema, 1, &chars, &length));
+    ASSERT_TRUE(length == 4 && memcmp(chars, "abcd", 4) == 0 && chars >= r->data
+            && chars < r->data + getRecordSize(schema), "view of a string filling its attribute");
+    TEST_CHECK(getStringAttrView(r, schema, 3, &chars, &length));
+    ASSERT_TRUE(length == 3 && memcmp(chars, "xyz", 3) == 0, "view of a varchar");
+
+    // NULLs, wrong types and bad attribute numbers are errors
+    ASSERT_TRUE(getFloatAttr(r, schema, 4, &floatV) == RC_RM_NULL_VALUE, "NULL float");
+    ASSERT_TRUE(getFloatAttr(r, schema, 0, &floatV) == RC_RM_ATTRIBUTE_TYPE_MISMATCH, "int read as float");
+    ASSERT_TRUE(getIntAttr(r, schema, 5, &intV) == RC_RM_INVALID_ATTRIBUTE, "attribute out of range");
+
+    MAKE_VALUE(value, DT_FLOAT, 1.5);
+    TEST_CHECK(setAttr(r, schema, 4, value));
+    freeVal(value);
+    TEST_CHECK(getFloatAttr(r, schema, 4, &floatV));
+    ASSERT_TRUE(floatV == 1.5, "float attribute");
+
+    freeRecord(r);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// RIDs of the records a vacuum test keeps, updated as the vacuum moves them
+typedef struct VacuumRids {
+    RID *rids;
+    int n;
+} VacuumRids;
+
+static void
+recordMoved(void *context, RID from, RID to)
+{
+    VacuumRids *tracked = (VacuumRids *) context;
+    int i;
+    for (i = 0; i < tracked->n; i++)
+        if (tracked->rids[i].page == from.page && tracked->rids[i].slot == from.slot)
+            tracked->rids[i] = to;
+}
+
+// ************************************************************
+void
+testVacuum(void)
+{
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 60, numKept = 0, steps = 0, i;
+    char b[5];
+    Record **records, *r;
+    RID *rids;
+    Schema *schema;
+    RM_managementData *mgmt;
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    RM_VacuumHandle vacuum;
+    RM_VacuumStats stats;
+    VacuumRids tracked;
+    struct stat before, after;
+    int pagesBefore;
+    bool done = false;
+    testName = "test incremental vacuum";
+    schema = testSchema();
+    records = (Record **) malloc(sizeof(Record *) * (numInserts + 1));
+    rids = (RID *) malloc(sizeof(RID) * (numInserts + 1));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r",schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    mgmt = (RM_managementData *) table->managementData;
+
+    // fill about ten pages, then delete two records of every three
+    for(i = 0; i < numInserts; i++)
+    {
+        sprintf(b, "v%03d", i);
+        records[i] = testRecord(schema, i, b, -i);
+        TEST_CHECK(insertRecord(table, records[i]));
+    }
+    for(i = 0; i < numInserts; i++)
+    {
+        if (i % 3 == 0)
+        {
+            records[numKept] = records[i];
+            rids[numKept++] = records[i]->id;
+        }
+        else
+        {
+            TEST_CHECK(deleteRecord(table, records[i]->id));
+            freeRecord(records[i]);
+        }
+    }
+    TEST_CHECK(checkpointTable(table));
+    stat("test_table_r", &before);
+    pagesBefore = mgmt->numPages - mgmt->numPageDP + 1;
+
+    // two pages a step, with an insert and reads between the steps
+    tracked.rids = rids;
+    tracked.n = numKept;
+    TEST_CHECK(startVacuum(table, &vacuum, recordMoved, &tracked));
+    while (!done)
+    {
+        TEST_CHECK(vacuumStep(&vacuum, 2, &done));
+        steps++;
+        if (steps == 3)
+        {
+            records[numKept] = testRecord(schema, 1000, "late", -1000);
+            TEST_CHECK(insertRecord(table, records[numKept]));
+            rids[numKept] = records[numKept]->id;
+            tracked.n = ++numKept;
+        }
+        createRecord(&r, schema);
+        TEST_CHECK(getRecord(table, rids[steps % numKept], r));
+        ASSERT_EQUALS_RECORDS(records[steps % numKept], r, schema, "record readable between vacuum steps");
+        freeRecord(r);
+    }
+    stats = vacuum.stats;
+    ASSERT_TRUE(steps > 1, "vacuum ran in several steps");
+    ASSERT_TRUE(stats.recordsMoved > 0 && stats.slotsTrimmed > 0, "records moved and slots trimmed");
+    ASSERT_TRUE(stats.pagesTruncated > 0, "empty pages cut from the end");
+    ASSERT_TRUE(stats.bytesReclaimed >= (long) stats.pagesTruncated * PAGE_SIZE, "reclaimed bytes include the cut pages");
+    ASSERT_TRUE(mgmt->numPages - mgmt->numPageDP + 1 < pagesBefore, "fewer data pages");
+
+    // the kept records read back at their new RIDs, and a scan sees each once
+    createRecord(&r, schema);
+    for(i = 0; i < numKept; i++)
+    {
+        TEST_CHECK(getRecord(table, rids[i], r));
+        ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare records after vacuum");
+    }
+    TEST_CHECK(startScan(table, sc, NULL));
+    for (i = 0; next(sc, r) == RC_OK; i++)
+        ;
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numKept, i, "scan after vacuum");
+
+    // the file shrank and the table reopens with the rewritten directory
+    TEST_CHECK(closeTable(table));
+    stat("test_table_r", &after);
+    ASSERT_TRUE(after.st_size == before.st_size - (long) stats.pagesTruncated * PAGE_SIZE, "file shrank by the cut pages");
+    TEST_CHECK(openTable(table, "test_table_r"));
+    for(i = 0; i < numKept; i++)
+    {
+        TEST_CHECK(getRecord(table, rids[i], r));
+        ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare records after reopening");
+    }
+
+    // without a callback nothing moves
+    TEST_CHECK(deleteRecord(table, rids[0]));
+    TEST_CHECK(vacuumTable(table, NULL, NULL, &stats));
+    ASSERT_EQUALS_INT(0, stats.recordsMoved, "no records moved without a callback");
+    for(i = 1; i < numKept; i++)
+        TEST_CHECK(getRecord(table, rids[i], r));
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    for(i = 0; i < numKept; i++)
+        freeRecord(records[i]);
+    freeSchema(schema);
+    free(records);
+    free(rids);
+    free(sc);
+    free(table);
+    TEST_DONE();
+}
+
 void
 testUpdateTable (void)
 {
@@ -0,0 +1,149 @@
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Number of events kept per thread, must be a power of two
+#define TRACE_RING_SIZE 4096
+
+// Per-thread ring buffer. Only the owning thread writes records; the head is
+// published with release semantics so a dumper can read it without locking.
+typedef struct TraceRing {
+	TraceRecord records[TRACE_RING_SIZE];
+	_Atomic uint64_t head;
+	uint64_t threadId;
+	struct TraceRing *next;
+} TraceRing;
+
+int traceRuntimeLevel = TRACE_LEVEL;
+
+// Lock-free list of every ring ever created
+static _Atomic(TraceRing *) traceRings = NULL;
+static _Atomic uint64_t traceNextThreadId = 1;
+static __thread TraceRing *threadRing = NULL;
+
+static const char *traceEventNames[TE_NUM_EVENTS] = {
+	[TE_LATCH_READ_ACQUIRE] = "latch_read_acquire",
+	[TE_LATCH_WRITE_ACQUIRE] = "latch_write_acquire",
+	[TE_LATCH_READ_RELEASE] = "latch_read_release",
+	[TE_LATCH_WRITE_RELEASE] = "latch_write_release",
+	[TE_LATCH_ERROR] = "latch_error",
+	[TE_PIN_HIT] = "pin_hit",
+	[TE_PIN_MISS] = "pin_miss",
+	[TE_PIN_FAILED] = "pin_failed",
+	[TE_UNPIN] = "unpin",
+	[TE_UNPIN_FAILED] = "unpin_failed",
+	[TE_MARK_DIRTY] = "mark_dirty",
+	[TE_FORCE_PAGE] = "force_page",
+	[TE_EVICT] = "evict",
+	[TE_OPEN_FILE] = "open_file",
+	[TE_CLOSE_FILE] = "close_file",
+	[TE_READ_BLOCK] = "read_block",
+	[TE_WRITE_BLOCK] = "write_block",
+	[TE_CREATE_RECORD] = "create_record",
+	[TE_FREE_RECORD] = "free_record",
+};
+
+// Creates the calling thread's ring and pushes it onto the global list
+static TraceRing *
+createThreadRing (void)
+{
+	TraceRing *ring = (TraceRing *) calloc(1, sizeof(TraceRing));
+	if (ring == NULL)
+		return NULL;
+
+	ring->threadId = atomic_fetch_add(&traceNextThreadId, 1);
+	TraceRing *first = atomic_load(&traceRings);
+	do {
+		ring->next = first;
+	} while (!atomic_compare_exchange_weak(&traceRings, &first, ring));
+
+	return ring;
+}
+
+/*
+ * Sets the runtime trace level. Events are recorded only if their level is at
+ * most both the compile-time TRACE_LEVEL and this runtime level.
+ */
+void
+traceSetLevel (int level)
+{
+	traceRuntimeLevel = level;
+}
+
+/*
+ * Appends one event to the calling thread's ring buffer, overwriting the
+ * oldest event once the ring is full. Called through the TRACE macros.
+ */
+void
+traceEmit (int level, TraceEvent event, uint64_t arg0, uint64_t arg1)
+{
+	TraceRing *ring = threadRing;
+	if (ring == NULL)
+	{
+		ring = threadRing = createThreadRing();
+		if (ring == NULL)
+			return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	TraceRecord *record = &ring->records[head & (TRACE_RING_SIZE - 1)];
+	record->timestamp = (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+	record->event = event;
+	record->level = level;
+	record->arg0 = arg0;
+	record->arg1 = arg1;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/*
+ * Writes the contents of every thread's ring buffer to a binary file that the
+ * trace_dump tool decodes. Events recorded while the dump runs may be torn;
+ * dump from a quiescent process for an exact picture.
+ *
+ * Returns:
+ * - RC_OK on success, RC_FILE_OPEN_FAILED or RC_WRITE_FAILED otherwise.
+ */
+RC
+traceDump (const char *fileName)
+{
+	FILE *file = fopen(fileName, "wb");
+	if (file == NULL)
+		return RC_FILE_OPEN_FAILED;
+
+	TraceFileHeader header = { TRACE_FILE_MAGIC, TRACE_FILE_VERSION, sizeof(TraceRecord), 0 };
+	for (TraceRing *ring = atomic_load(&traceRings); ring != NULL; ring = ring->next)
+		header.numThreads++;
+
+	int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+	for (TraceRing *ring = atomic_load(&traceRings); ok && ring != NULL; ring = ring->next)
+	{
+		uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		uint64_t count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+		TraceThreadHeader threadHeader = { ring->threadId, count, head - count };
+		ok = fwrite(&threadHeader, sizeof(threadHeader), 1, file) == 1;
+
+		// Oldest surviving event first
+		for (uint64_t i = head - count; ok && i < head; i++)
+			ok = fwrite(&ring->records[i & (TRACE_RING_SIZE - 1)], sizeof(TraceRecord), 1, file) == 1;
+	}
+
+	if (fclose(file) != 0 || !ok)
+		return RC_WRITE_FAILED;
+	return RC_OK;
+}
+
+// Returns the printable name of a trace event
+const char *
+traceEventName (uint32_t event)
+{
+	if (event < TE_NUM_EVENTS && traceEventNames[event] != NULL)
+		return traceEventNames[event];
+	return "unknown";
+}
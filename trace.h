@@ -0,0 +1,99 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#include "dberror.h"
+
+/************************************************************
+ *                    trace levels                          *
+ ************************************************************/
+// Events above the compile-time level compile to nothing.
+// Build with e.g. "make TRACE_LEVEL=3" to keep every event.
+#define TRACE_LEVEL_OFF 0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_INFO 2
+#define TRACE_LEVEL_DEBUG 3
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_OFF
+#endif
+
+/************************************************************
+ *                    trace events                          *
+ ************************************************************/
+typedef enum TraceEvent {
+	TE_LATCH_READ_ACQUIRE = 1,
+	TE_LATCH_WRITE_ACQUIRE = 2,
+	TE_LATCH_READ_RELEASE = 3,
+	TE_LATCH_WRITE_RELEASE = 4,
+	TE_LATCH_ERROR = 5,
+	TE_PIN_HIT = 6,
+	TE_PIN_MISS = 7,
+	TE_PIN_FAILED = 8,
+	TE_UNPIN = 9,
+	TE_UNPIN_FAILED = 10,
+	TE_MARK_DIRTY = 11,
+	TE_FORCE_PAGE = 12,
+	TE_EVICT = 13,
+	TE_OPEN_FILE = 14,
+	TE_CLOSE_FILE = 15,
+	TE_READ_BLOCK = 16,
+	TE_WRITE_BLOCK = 17,
+	TE_CREATE_RECORD = 18,
+	TE_FREE_RECORD = 19,
+	TE_NUM_EVENTS
+} TraceEvent;
+
+// One binary trace event, as stored in the ring buffers and in dump files
+typedef struct TraceRecord {
+	uint64_t timestamp;  // CLOCK_MONOTONIC in nanoseconds
+	uint32_t event;      // TraceEvent
+	uint32_t level;
+	uint64_t arg0;
+	uint64_t arg1;
+} TraceRecord;
+
+// Dump file layout: TraceFileHeader, then per thread a TraceThreadHeader
+// followed by its records, oldest first.
+#define TRACE_FILE_MAGIC 0x45435254
+#define TRACE_FILE_VERSION 1
+
+typedef struct TraceFileHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t numThreads;
+} TraceFileHeader;
+
+typedef struct TraceThreadHeader {
+	uint64_t threadId;
+	uint64_t numRecords;
+	uint64_t numDropped;  // events overwritten before the dump
+} TraceThreadHeader;
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+extern int traceRuntimeLevel;
+
+extern void traceSetLevel (int level);
+extern void traceEmit (int level, TraceEvent event, uint64_t arg0, uint64_t arg1);
+extern RC traceDump (const char *fileName);
+extern const char *traceEventName (uint32_t event);
+
+#if TRACE_LEVEL > TRACE_LEVEL_OFF
+#define TRACE(level, event, arg0, arg1)					\
+		do {									\
+			if ((level) <= TRACE_LEVEL && (level) <= traceRuntimeLevel)	\
+				traceEmit((level), (event), (uint64_t) (arg0), (uint64_t) (arg1)); \
+		} while (0)
+#else
+#define TRACE(level, event, arg0, arg1) do { } while (0)
+#endif
+
+#define TRACE_ERROR(event, arg0, arg1) TRACE(TRACE_LEVEL_ERROR, event, arg0, arg1)
+#define TRACE_INFO(event, arg0, arg1) TRACE(TRACE_LEVEL_INFO, event, arg0, arg1)
+#define TRACE_DEBUG(event, arg0, arg1) TRACE(TRACE_LEVEL_DEBUG, event, arg0, arg1)
+
+#endif // TRACE_H
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "trace.h"
+
+/*
+ * Decodes a binary trace file written by traceDump and prints one line per
+ * event: thread, timestamp relative to the first event, level, name and args.
+ *
+ * Usage: trace_dump <trace file>
+ */
+int
+main (int argc, char **argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", argv[1]);
+		return 1;
+	}
+
+	TraceFileHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != TRACE_FILE_MAGIC
+			|| header.version != TRACE_FILE_VERSION || header.recordSize != sizeof(TraceRecord))
+	{
+		fprintf(stderr, "%s is not a trace file of this version\n", argv[1]);
+		fclose(file);
+		return 1;
+	}
+
+	uint64_t base = 0;
+	for (uint32_t t = 0; t < header.numThreads; t++)
+	{
+		TraceThreadHeader threadHeader;
+		if (fread(&threadHeader, sizeof(threadHeader), 1, file) != 1)
+			break;
+
+		printf("# thread %llu: %llu events, %llu dropped\n",
+				(unsigned long long) threadHeader.threadId,
+				(unsigned long long) threadHeader.numRecords,
+				(unsigned long long) threadHeader.numDropped);
+
+		for (uint64_t i = 0; i < threadHeader.numRecords; i++)
+		{
+			TraceRecord record;
+			if (fread(&record, sizeof(record), 1, file) != 1)
+				break;
+			if (base == 0)
+				base = record.timestamp;
+
+			printf("%llu %12.3f us L%u %-20s %llu %llu\n",
+					(unsigned long long) threadHeader.threadId,
+					(double) (int64_t) (record.timestamp - base) / 1000.0,
+					record.level,
+					traceEventName(record.event),
+					(unsigned long long) record.arg0,
+					(unsigned long long) record.arg1);
+		}
+	}
+
+	fclose(file);
+	return 0;
+}
@@ -0,0 +1,500 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "buffer_mgr.h"
+#include "latency.h"
+#include "metrics.h"
+#include "record_mgr.h"
+#include "tables.h"
+
+/*
+ * YCSB-style workload generator over the record manager API. Loads a table of
+ * (int key, char[4] b, int field) rows, then runs client threads against it
+ * for a fixed time and reports throughput and latency percentiles per
+ * operation type.
+ *
+ * Usage: ycsb [--workload A|B|C|E|F] [--records N] [--threads T] [--seconds S]
+ *             [--distribution uniform|zipfian|latest] [--pool P] [--json <file>]
+ *             [--metrics <file>]
+ *
+ * Workloads follow the YCSB core set:
+ *   A  50% read, 50% update
+ *   B  95% read, 5% update
+ *   C  100% read
+ *   E  95% short scan, 5% insert
+ *   F  50% read, 50% read-modify-write
+ *
+ * The record manager shares one page handle per table and is not thread-safe,
+ * so every call into it is serialised by one mutex. Latencies include the
+ * time spent waiting for that mutex, as a client would see it.
+ *
+ * With --metrics, a snapshot of the table, its buffer pool and the latency
+ * histograms is appended to the file as a JSON line every second of the run.
+ */
+
+#define YCSB_TABLE "ycsb_table.bin"
+#define YCSB_SEED 42
+#define YCSB_ZIPF_THETA 0.99
+#define YCSB_MAX_SCAN_LENGTH 100
+#define YCSB_METRICS_INTERVAL_MS 1000
+
+typedef enum YcsbOp {
+	YCSB_READ = 0,
+	YCSB_UPDATE = 1,
+	YCSB_INSERT = 2,
+	YCSB_SCAN = 3,
+	YCSB_READ_MODIFY_WRITE = 4,
+	YCSB_NUM_OPS
+} YcsbOp;
+
+static const char *ycsbOpNames[YCSB_NUM_OPS] = {
+	[YCSB_READ] = "read",
+	[YCSB_UPDATE] = "update",
+	[YCSB_INSERT] = "insert",
+	[YCSB_SCAN] = "scan",
+	[YCSB_READ_MODIFY_WRITE] = "read_modify_write",
+};
+
+typedef enum YcsbDistribution {
+	DIST_UNIFORM,
+	DIST_ZIPFIAN,
+	DIST_LATEST
+} YcsbDistribution;
+
+// Share of each operation in a workload, in percent
+typedef struct YcsbMix {
+	char name;
+	int percent[YCSB_NUM_OPS];
+} YcsbMix;
+
+static const YcsbMix ycsbMixes[] = {
+	{'A', {[YCSB_READ] = 50, [YCSB_UPDATE] = 50}},
+	{'B', {[YCSB_READ] = 95, [YCSB_UPDATE] = 5}},
+	{'C', {[YCSB_READ] = 100}},
+	{'E', {[YCSB_SCAN] = 95, [YCSB_INSERT] = 5}},
+	{'F', {[YCSB_READ] = 50, [YCSB_READ_MODIFY_WRITE] = 50}},
+};
+
+// State shared by all client threads; everything below the lock is guarded by it
+typedef struct YcsbTable {
+	pthread_mutex_t lock;
+	RM_TableData table;
+	Schema *schema;
+	RID *rids;         // RID of every key, indexed by key
+	int numKeys;       // keys [0, numKeys) exist
+	int capacity;
+} YcsbTable;
+
+typedef struct YcsbClient {
+	pthread_t thread;
+	int id;
+	YcsbTable *shared;
+	const YcsbMix *mix;
+	YcsbDistribution distribution;
+	ZipfGenerator *zipf;
+	double seconds;
+	long ops[YCSB_NUM_OPS];
+	long errors;
+	LatencyHistogram *histograms;  // one per operation
+} YcsbClient;
+
+// Schema of the workload table: (int a, char[4] b, int c), keyed on a
+static Schema *
+ycsbSchema (void)
+{
+	char **names = (char **) malloc(sizeof(char *) * 3);
+	DataType *dataTypes = (DataType *) malloc(sizeof(DataType) * 3);
+	int *typeLength = (int *) malloc(sizeof(int) * 3);
+	int *keys = (int *) malloc(sizeof(int));
+
+	names[0] = strdup("a");
+	names[1] = strdup("b");
+	names[2] = strdup("c");
+	dataTypes[0] = DT_INT;
+	dataTypes[1] = DT_STRING;
+	dataTypes[2] = DT_INT;
+	typeLength[0] = 0;
+	typeLength[1] = 4;
+	typeLength[2] = 0;
+	keys[0] = 0;
+
+	return createSchema(3, names, dataTypes, typeLength, 1, keys);
+}
+
+// Fills a record with a key and field value
+static void
+fillRecord (Record *record, Schema *schema, int key, int field)
+{
+	Value value;
+
+	value.dt = DT_INT;
+	value.v.intV = key;
+	setAttr(record, schema, 0, &value);
+	value.dt = DT_STRING;
+	value.v.stringV = "ycsb";
+	setAttr(record, schema, 1, &value);
+	value.dt = DT_INT;
+	value.v.intV = field;
+	setAttr(record, schema, 2, &value);
+}
+
+// Spreads zipfian ranks over the key space so hot keys do not share pages (FNV-1a)
+static int
+scrambleKey (int rank, int numKeys)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for (int i = 0; i < 4; i++)
+	{
+		hash ^= (uint64_t) ((rank >> (8 * i)) & 0xFF);
+		hash *= 0x100000001B3ULL;
+	}
+	return (int) (hash % (uint64_t) numKeys);
+}
+
+// Picks the key of the next operation among keys [0, numKeys)
+static int
+nextKey (YcsbClient *client, BenchRng *rng, int numKeys)
+{
+	int rank;
+
+	switch (client->distribution)
+	{
+		case DIST_ZIPFIAN:
+			rank = zipfNext(client->zipf, rng);
+			return scrambleKey(rank, numKeys);
+		case DIST_LATEST:
+			// The most recently inserted keys are the most popular
+			rank = zipfNext(client->zipf, rng);
+			return rank < numKeys ? numKeys - 1 - rank : 0;
+		default:
+			return benchRngRange(rng, numKeys);
+	}
+}
+
+// Picks an operation according to the workload mix
+static YcsbOp
+nextOp (const YcsbMix *mix, BenchRng *rng)
+{
+	int roll = benchRngRange(rng, 100);
+	for (int op = 0; op < YCSB_NUM_OPS; op++)
+	{
+		roll -= mix->percent[op];
+		if (roll < 0)
+			return (YcsbOp) op;
+	}
+	return YCSB_READ;
+}
+
+// Appends a key's RID, growing the key array as needed. Caller holds the lock.
+static RC
+addKey (YcsbTable *shared, RID rid)
+{
+	if (shared->numKeys == shared->capacity)
+	{
+		int capacity = 2 * shared->capacity;
+		RID *rids = (RID *) realloc(shared->rids, sizeof(RID) * capacity);
+		if (rids == NULL)
+			return RC_MEMORY_ALLOCATION_FAIL;
+		shared->rids = rids;
+		shared->capacity = capacity;
+	}
+	shared->rids[shared->numKeys++] = rid;
+	return RC_OK;
+}
+
+// Reads up to YCSB_MAX_SCAN_LENGTH consecutive keys starting at key. Caller holds the lock.
+static RC
+shortScan (YcsbTable *shared, int key, int length, Record **records)
+{
+	if (key + length > shared->numKeys)
+		length = shared->numKeys - key;
+	if (length <= 0)
+		return RC_OK;
+	return getRecords(&shared->table, &shared->rids[key], records, length);
+}
+
+// Runs one operation and returns its result
+static RC
+runOp (YcsbClient *client, YcsbOp op, BenchRng *rng, Record *record, Record **scanRecords)
+{
+	YcsbTable *shared = client->shared;
+	int counter;
+	RC rc = RC_OK;
+
+	pthread_mutex_lock(&shared->lock);
+	int numKeys = shared->numKeys;
+	int key = nextKey(client, rng, numKeys);
+
+	switch (op)
+	{
+		case YCSB_READ:
+			rc = getRecord(&shared->table, shared->rids[key], record);
+			break;
+		case YCSB_UPDATE:
+			// An update that no longer fits its slot moves the record
+			fillRecord(record, shared->schema, key, (int) benchRngNext(rng));
+			record->id = shared->rids[key];
+			rc = updateRecord(&shared->table, record);
+			if (rc == RC_OK)
+				shared->rids[key] = record->id;
+			break;
+		case YCSB_READ_MODIFY_WRITE:
+			rc = getRecord(&shared->table, shared->rids[key], record);
+			if (rc == RC_OK && (rc = getIntAttr(record, shared->schema, 2, &counter)) == RC_OK)
+			{
+				fillRecord(record, shared->schema, key, counter + 1);
+				record->id = shared->rids[key];
+				rc = updateRecord(&shared->table, record);
+				if (rc == RC_OK)
+					shared->rids[key] = record->id;
+			}
+			break;
+		case YCSB_INSERT:
+			fillRecord(record, shared->schema, numKeys, 0);
+			rc = insertRecord(&shared->table, record);
+			if (rc == RC_OK)
+				rc = addKey(shared, record->id);
+			break;
+		case YCSB_SCAN:
+			rc = shortScan(shared, key, 1 + benchRngRange(rng, YCSB_MAX_SCAN_LENGTH), scanRecords);
+			break;
+		default:
+			break;
+	}
+
+	pthread_mutex_unlock(&shared->lock);
+	return rc;
+}
+
+// Client thread: issues operations until its time is up
+static void *
+clientMain (void *arg)
+{
+	YcsbClient *client = (YcsbClient *) arg;
+	Schema *schema = client->shared->schema;
+	Record *record;
+	Record *scanRecords[YCSB_MAX_SCAN_LENGTH];
+	BenchRng rng;
+
+	benchRngSeed(&rng, YCSB_SEED + client->id);
+	createRecord(&record, schema);
+	for (int i = 0; i < YCSB_MAX_SCAN_LENGTH; i++)
+		createRecord(&scanRecords[i], schema);
+
+	double end = benchSeconds() + client->seconds;
+	while (benchSeconds() < end)
+	{
+		YcsbOp op = nextOp(client->mix, &rng);
+		uint64_t start = latencyNow();
+		RC rc = runOp(client, op, &rng, record, scanRecords);
+		latencyHistogramAdd(&client->histograms[op], latencyNow() - start);
+
+		client->ops[op]++;
+		if (rc != RC_OK)
+			client->errors++;
+	}
+
+	freeRecord(record);
+	for (int i = 0; i < YCSB_MAX_SCAN_LENGTH; i++)
+		freeRecord(scanRecords[i]);
+	return NULL;
+}
+
+// Creates the table and inserts keys [0, numRecords)
+static RC
+loadTable (YcsbTable *shared, int numRecords, int poolSize)
+{
+	Record *record;
+	RC rc;
+
+	if ((rc = createTable(YCSB_TABLE, shared->schema)) != RC_OK)
+		return rc;
+	if ((rc = openTableWithPoolSize(&shared->table, YCSB_TABLE, poolSize)) != RC_OK)
+		return rc;
+
+	createRecord(&record, shared->schema);
+	for (int i = 0; i < numRecords && rc == RC_OK; i++)
+	{
+		fillRecord(record, shared->schema, i, 0);
+		if ((rc = insertRecord(&shared->table, record)) == RC_OK)
+			rc = addKey(shared, record->id);
+	}
+	freeRecord(record);
+	return rc;
+}
+
+static void
+usage (const char *program)
+{
+	fprintf(stderr, "usage: %s [--workload A|B|C|E|F] [--records N] [--threads T] [--seconds S]\n"
+			"       [--distribution uniform|zipfian|latest] [--pool P] [--json <file>]\n"
+			"       [--metrics <file>]\n", program);
+}
+
+int
+main (int argc, char **argv)
+{
+	const char *jsonFile = "ycsb.json";
+	const char *metricsFile = NULL;
+	const YcsbMix *mix = &ycsbMixes[0];
+	YcsbDistribution distribution = DIST_ZIPFIAN;
+	int numRecords = 1000;
+	int numThreads = 4;
+	int poolSize = 64;
+	double seconds = 5.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		const char *param = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if (param == NULL)
+		{
+			usage(argv[0]);
+			return 1;
+		}
+		i++;
+		if (strcmp(arg, "--workload") == 0)
+		{
+			mix = NULL;
+			for (size_t m = 0; m < sizeof(ycsbMixes) / sizeof(ycsbMixes[0]); m++)
+				if (ycsbMixes[m].name == param[0] && param[1] == '\0')
+					mix = &ycsbMixes[m];
+			if (mix == NULL)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+		else if (strcmp(arg, "--records") == 0)
+			numRecords = atoi(param);
+		else if (strcmp(arg, "--threads") == 0)
+			numThreads = atoi(param);
+		else if (strcmp(arg, "--seconds") == 0)
+			seconds = atof(param);
+		else if (strcmp(arg, "--pool") == 0)
+			poolSize = atoi(param);
+		else if (strcmp(arg, "--json") == 0)
+			jsonFile = param;
+		else if (strcmp(arg, "--metrics") == 0)
+			metricsFile = param;
+		else if (strcmp(arg, "--distribution") == 0 && strcmp(param, "uniform") == 0)
+			distribution = DIST_UNIFORM;
+		else if (strcmp(arg, "--distribution") == 0 && strcmp(param, "zipfian") == 0)
+			distribution = DIST_ZIPFIAN;
+		else if (strcmp(arg, "--distribution") == 0 && strcmp(param, "latest") == 0)
+			distribution = DIST_LATEST;
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (numRecords <= 0 || numThreads <= 0 || seconds <= 0 || poolSize <= 0)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	YcsbTable shared;
+	memset(&shared, 0, sizeof(shared));
+	pthread_mutex_init(&shared.lock, NULL);
+	shared.schema = ycsbSchema();
+	shared.capacity = numRecords;
+	shared.rids = (RID *) malloc(sizeof(RID) * numRecords);
+
+	// Leftovers of an interrupted run would make the table creation fail
+	remove(YCSB_TABLE);
+	initRecordManager(NULL);
+
+	double start = benchSeconds();
+	RC rc = loadTable(&shared, numRecords, poolSize);
+	double loadSeconds = benchSeconds() - start;
+	if (rc != RC_OK)
+	{
+		fprintf(stderr, "ycsb: loading failed after %d records (rc %d)\n", shared.numKeys, rc);
+		return 1;
+	}
+
+	// Ranks of the zipfian and latest distributions span the loaded keys
+	ZipfGenerator zipf;
+	zipfInit(&zipf, numRecords, YCSB_ZIPF_THETA);
+
+	YcsbClient *clients = (YcsbClient *) calloc(numThreads, sizeof(YcsbClient));
+	for (int t = 0; t < numThreads; t++)
+	{
+		clients[t].id = t;
+		clients[t].shared = &shared;
+		clients[t].mix = mix;
+		clients[t].distribution = distribution;
+		clients[t].zipf = &zipf;
+		clients[t].seconds = seconds;
+		clients[t].histograms = (LatencyHistogram *) calloc(YCSB_NUM_OPS, sizeof(LatencyHistogram));
+	}
+
+	if (metricsFile != NULL
+			&& (metricsWatchTable(&shared.table) != RC_OK
+				|| startMetricsReporter(metricsFile, YCSB_METRICS_INTERVAL_MS) != RC_OK))
+		fprintf(stderr, "ycsb: cannot write metrics to %s\n", metricsFile);
+
+	start = benchSeconds();
+	for (int t = 0; t < numThreads; t++)
+		pthread_create(&clients[t].thread, NULL, clientMain, &clients[t]);
+	for (int t = 0; t < numThreads; t++)
+		pthread_join(clients[t].thread, NULL);
+	double runSeconds = benchSeconds() - start;
+	if (metricsFile != NULL)
+		stopMetricsReporter();
+
+	// Merge the clients' results per operation
+	LatencyHistogram *total = (LatencyHistogram *) calloc(YCSB_NUM_OPS + 1, sizeof(LatencyHistogram));
+	long ops[YCSB_NUM_OPS] = {0};
+	long allOps = 0, errors = 0;
+	for (int t = 0; t < numThreads; t++)
+	{
+		for (int op = 0; op < YCSB_NUM_OPS; op++)
+		{
+			ops[op] += clients[t].ops[op];
+			allOps += clients[t].ops[op];
+			latencyHistogramMerge(&total[op], &clients[t].histograms[op]);
+			latencyHistogramMerge(&total[YCSB_NUM_OPS], &clients[t].histograms[op]);
+		}
+		errors += clients[t].errors;
+	}
+
+	char suite[BENCH_NAME_LENGTH];
+	const char *distributionNames[] = {"uniform", "zipfian", "latest"};
+	BenchReport report;
+
+	snprintf(suite, sizeof(suite), "ycsb_%c_%s_%dthreads", mix->name, distributionNames[distribution], numThreads);
+	benchReportInit(&report, suite);
+	benchReportAdd(&report, "load", numRecords, loadSeconds, -1);
+	benchReportAddLatency(&report, "overall", allOps, runSeconds, &total[YCSB_NUM_OPS]);
+	for (int op = 0; op < YCSB_NUM_OPS; op++)
+	{
+		if (ops[op] == 0)
+			continue;
+		benchReportAddLatency(&report, ycsbOpNames[op], ops[op], runSeconds, &total[op]);
+	}
+	if (errors > 0)
+		fprintf(stderr, "ycsb: %ld operations failed\n", errors);
+
+	rc = benchReportWriteJson(&report, jsonFile);
+	if (rc != RC_OK)
+		fprintf(stderr, "ycsb: cannot write %s\n", jsonFile);
+
+	benchReportFree(&report);
+	for (int t = 0; t < numThreads; t++)
+		free(clients[t].histograms);
+	free(clients);
+	free(total);
+	closeTable(&shared.table);
+	deleteTable(YCSB_TABLE);
+	shutdownRecordManager();
+	freeSchema(shared.schema);
+	free(shared.rids);
+	pthread_mutex_destroy(&shared.lock);
+	return rc == RC_OK && errors == 0 ? 0 : 1;
+}